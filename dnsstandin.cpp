@@ -0,0 +1,305 @@
+//
+// Copyright (c) 2022 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// A stand-in DNS server for micburs --native-dns, answering over UDP and TCP
+// on the same port. Its answers depend on the name asked, so every path of
+// the built-in client can be tried without a real nameserver:
+//
+//	NAME.ok.test        A 127.0.0.1 and AAAA ::1
+//	NAME.big.test       Truncated over UDP, 40 A records over TCP
+//	NAME.hang.test      Truncated over UDP, TCP connections never answered
+//	NAME.drop.test      Every other question is not answered at all
+//	NAME.servfail.test  Always SERVFAIL
+//	anything else       NXDOMAIN
+
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <boost/asio.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <map>
+#include <algorithm>
+#include <stdexcept>
+
+namespace asio = boost::asio;
+namespace ip = asio::ip;
+using ip::tcp;
+using ip::udp;
+using namespace std::string_literals;
+
+struct DnsStandinOptions {
+	std::string address = "127.0.0.1";
+	unsigned short port = 5353;
+	std::uint32_t ttl = 30;
+
+	DnsStandinOptions(int argc, char * argv[]) {
+		for (int i=1; i<argc; ++i) {
+			const std::string_view arg{argv[i]};
+			auto value = [&] () -> std::string {
+				if (i+1 >= argc)
+					throw std::runtime_error{"Missing value for "s + argv[i]};
+				return argv[++i];
+			};
+			if (arg == "--address")
+				address = value();
+			else if (arg == "--port")
+				port = static_cast<unsigned short>(std::stoul(value()));
+			else if (arg == "--ttl")
+				ttl = std::stoul(value());
+			else if (arg == "--help" || arg == "-h")
+				throw std::runtime_error{usage()};
+			else
+				throw std::runtime_error{"Unknown option: "s + argv[i] + "\n" + usage()};
+		}
+	}
+	static std::string usage() {
+		return
+			"Usage: dnsstandin [options]\n"
+			"  --address ADDR    Address to listen on (default 127.0.0.1)\n"
+			"  --port PORT       UDP and TCP port to listen on (default 5353)\n"
+			"  --ttl SECONDS     TTL of every record (default 30)\n";
+	}
+};
+
+// Builds the answer to one query, or nothing when the query is to be
+// dropped. Queries that are no DNS question at all are dropped too.
+class DnsStandinZone {
+private:
+	enum : std::uint16_t {
+		typeA = 1,
+		typeAAAA = 28
+	};
+	enum : std::uint16_t {
+		rcodeServFail = 2,
+		rcodeNameError = 3
+	};
+	const std::uint32_t ttl;
+	std::map<std::string, std::size_t> dropCounts;
+public:
+	explicit DnsStandinZone(std::uint32_t _ttl_)
+	:
+		ttl{_ttl_}
+	{
+	}
+	std::vector<uint8_t> answer(const uint8_t * data, std::size_t size, bool overTcp) {
+		if (size < 12 || (data[2] & 0x80) != 0 || data[4] != 0 || data[5] != 1)
+			return {};
+		std::string name;
+		std::size_t offset = 12;
+		while (offset < size && data[offset] != 0) {
+			const std::size_t length = data[offset];
+			if ((length & 0xc0) != 0 || offset + 1 + length > size)
+				return {};
+			if (!name.empty())
+				name += '.';
+			for (std::size_t i=0; i<length; ++i)
+				name += static_cast<char>(std::tolower(data[offset + 1 + i]));
+			offset += 1 + length;
+		}
+		if (offset + 5 > size)
+			return {};
+		const std::uint16_t type = (data[offset + 1] << 8) | data[offset + 2];
+		const std::size_t questionEnd = offset + 5;
+
+		std::vector<uint8_t> response(data, data + questionEnd);
+		response[2] = 0x80 | (data[2] & 0x01); // Response, recursion desired as asked
+		response[3] = 0x80; // Recursion available
+		auto records = [&] (std::size_t count) {
+			response[6] = static_cast<uint8_t>(count >> 8);
+			response[7] = static_cast<uint8_t>(count);
+		};
+		if (this->under(name, "drop.test") && dropCounts[name + '/' + std::to_string(type)]++ % 2 == 0)
+			return {};
+		if (this->under(name, "servfail.test")) {
+			response[3] |= rcodeServFail;
+			return response;
+		}
+		if ((this->under(name, "big.test") || this->under(name, "hang.test")) && !overTcp) {
+			response[2] |= 0x02; // Truncated
+			return response;
+		}
+		if (this->under(name, "hang.test"))
+			return {};
+		if (this->under(name, "big.test")) {
+			const std::size_t count = type == typeA ? 40 : 0;
+			records(count);
+			for (std::size_t i=0; i<count; ++i)
+				this->record(response, type, {127, 0, 1, static_cast<uint8_t>(i + 1)});
+			return response;
+		}
+		if (this->under(name, "ok.test") || this->under(name, "drop.test")) {
+			records(1);
+			if (type == typeA)
+				this->record(response, type, {127, 0, 0, 1});
+			else if (type == typeAAAA)
+				this->record(response, type, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+			else
+				records(0);
+			return response;
+		}
+		response[3] |= rcodeNameError;
+		return response;
+	}
+private:
+	static bool under(std::string_view name, std::string_view zone) {
+		return name.size() > zone.size() && name.ends_with(zone) && name[name.size() - zone.size() - 1] == '.';
+	}
+	// The owner name points back to the question.
+	void record(std::vector<uint8_t> & response, std::uint16_t type, std::vector<uint8_t> address) const {
+		response.insert(response.end(), {
+			0xc0, 0x0c,
+			static_cast<uint8_t>(type >> 8), static_cast<uint8_t>(type),
+			0x00, 0x01,
+			static_cast<uint8_t>(ttl >> 24), static_cast<uint8_t>(ttl >> 16),
+			static_cast<uint8_t>(ttl >> 8), static_cast<uint8_t>(ttl),
+			0x00, static_cast<uint8_t>(address.size())
+		});
+		response.insert(response.end(), address.begin(), address.end());
+	}
+};
+
+// One TCP client: length prefixed questions, answered in order until the
+// client closes the connection.
+class DnsStandinConnection: public std::enable_shared_from_this<DnsStandinConnection> {
+private:
+	tcp::socket socket;
+	DnsStandinZone & zone;
+	std::array<uint8_t, 2> length;
+	std::vector<uint8_t> message;
+public:
+	DnsStandinConnection(
+		tcp::socket && _socket_,
+		DnsStandinZone & _zone_
+	)
+	:
+		socket{std::move(_socket_)},
+		zone{_zone_}
+	{
+	}
+	void read() {
+		asio::async_read(
+			socket,
+			asio::buffer(length),
+			[self=this->shared_from_this()] (
+				boost::system::error_code ec,
+				std::size_t
+			) {
+				if (ec)
+					return;
+				self->message.resize((self->length[0] << 8) | self->length[1]);
+				asio::async_read(
+					self->socket,
+					asio::buffer(self->message),
+					[self=self] (
+						boost::system::error_code ec,
+						std::size_t
+					) {
+						if (ec)
+							return;
+						self->write(self->zone.answer(self->message.data(), self->message.size(), true));
+					}
+				);
+			}
+		);
+	}
+private:
+	void write(std::vector<uint8_t> response) {
+		if (response.empty())
+			return this->read(); // Keeps the connection open without an answer
+		message = {static_cast<uint8_t>(response.size() >> 8), static_cast<uint8_t>(response.size())};
+		message.insert(message.end(), response.begin(), response.end());
+		asio::async_write(
+			socket,
+			asio::buffer(message),
+			[self=this->shared_from_this()] (
+				boost::system::error_code ec,
+				std::size_t
+			) {
+				if (ec)
+					return;
+				self->read();
+			}
+		);
+	}
+};
+
+// Everything runs on one thread, so the zone needs no lock.
+class DnsStandinServer {
+private:
+	asio::io_context ioContext;
+	udp::socket udpSocket;
+	tcp::acceptor acceptor;
+	DnsStandinZone zone;
+	std::array<uint8_t, 512> datagram;
+	udp::endpoint sender;
+public:
+	explicit DnsStandinServer(const DnsStandinOptions & options)
+	:
+		udpSocket{ioContext, udp::endpoint{ip::make_address(options.address), options.port}},
+		acceptor{ioContext, tcp::endpoint{ip::make_address(options.address), options.port}},
+		zone{options.ttl}
+	{
+	}
+	udp::endpoint endpoint() const {
+		return udpSocket.local_endpoint();
+	}
+	void run() {
+		this->receive();
+		this->accept();
+		ioContext.run();
+	}
+private:
+	void receive() {
+		udpSocket.async_receive_from(
+			asio::buffer(datagram),
+			sender,
+			[this] (
+				boost::system::error_code ec,
+				std::size_t size
+			) {
+				if (!ec) {
+					auto response = std::make_shared<std::vector<uint8_t>>(zone.answer(datagram.data(), size, false));
+					if (!response->empty())
+						udpSocket.async_send_to(
+							asio::buffer(*response),
+							sender,
+							[response] (boost::system::error_code, std::size_t) {}
+						);
+				}
+				this->receive();
+			}
+		);
+	}
+	void accept() {
+		acceptor.async_accept(
+			[this] (
+				boost::system::error_code ec,
+				tcp::socket socket
+			) {
+				if (!ec)
+					std::make_shared<DnsStandinConnection>(std::move(socket), zone)->read();
+				this->accept();
+			}
+		);
+	}
+};
+
+int main(int argc, char * argv[]) try {
+	const DnsStandinOptions options{argc, argv};
+	DnsStandinServer server{options};
+	std::cerr << "dnsstandin listening on " << server.endpoint() << " (UDP and TCP), TTL "
+		<< options.ttl << "s" << std::endl;
+	server.run();
+} catch (std::exception & exc) {
+	std::cerr << exc.what() << std::endl;
+	return 2;
+}
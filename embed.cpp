@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2022 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// Build tool: writes the given media files into one header as constexpr
+// byte arrays, so micburs runs without the media directory next to it.
+//
+//	embed OUTPUT.hpp media/audio/click.ogg media/fonts/...
+//
+// Each file is named by its path below the last "media/" directory. The
+// bytes are written as lists of integers: string literals would compile
+// faster, but MSVC does not take one longer than 64 KiB.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+std::string mediaName(std::string path) {
+	std::replace(path.begin(), path.end(), '\\', '/');
+	const auto media = path.rfind("media/");
+	return media == std::string::npos ? path : path.substr(media + 6);
+}
+
+std::string readFile(const std::string & path) {
+	std::ifstream in{path, std::ios::binary};
+	if (!in)
+		throw std::runtime_error{"embed: can not read " + path};
+	std::ostringstream bytes;
+	bytes << in.rdbuf();
+	return bytes.str();
+}
+
+// Decimal, which is shorter than hex for most bytes.
+void writeBytes(std::ostream & out, std::string_view bytes) {
+	constexpr std::size_t lineBytes = 32;
+	for (std::size_t begin=0; begin<bytes.size(); begin+=lineBytes) {
+		out << '\t';
+		for (const char c: bytes.substr(begin, lineBytes))
+			out << unsigned{static_cast<unsigned char>(c)} << ',';
+		out << '\n';
+	}
+}
+
+int main(int argc, char * argv[]) try {
+	if (argc < 2)
+		throw std::runtime_error{"Usage: embed OUTPUT.hpp FILE..."};
+	std::ostringstream out;
+	out << "// Made by embed from the media directory at build time, do not edit.\n"
+		"#pragma once\n"
+		"#include <span>\n"
+		"#include <string_view>\n\n"
+		"namespace embeddedMedia {\n\n"
+		"struct File {\n"
+		"\tstd::string_view name; // Path below media/\n"
+		"\tstd::span<const unsigned char> bytes;\n"
+		"};\n\n";
+	std::vector<std::string> names;
+	std::vector<std::size_t> sizes;
+	for (int i=2; i<argc; ++i) {
+		const std::string bytes = readFile(argv[i]);
+		out << "inline constexpr unsigned char file" << names.size() << "[] = { // " << mediaName(argv[i]) << '\n';
+		writeBytes(out, bytes);
+		if (bytes.empty())
+			out << "\t0 // An array can not be empty\n";
+		out << "};\n\n";
+		names.push_back(mediaName(argv[i]));
+		sizes.push_back(bytes.size());
+	}
+	out << "inline constexpr File files[] = {\n";
+	for (std::size_t i=0; i<names.size(); ++i)
+		out << "\t{\"" << names[i] << "\", {file" << i << ", " << sizes[i] << "}},\n";
+	if (names.empty())
+		out << "\t{\"\", {}},\n";
+	out << "};\n\n"
+		"} // namespace embeddedMedia\n";
+	std::ofstream{argv[1], std::ios::binary} << out.str();
+} catch (std::exception & exc) {
+	std::cerr << exc.what() << std::endl;
+	return 2;
+}
@@ -6,19 +6,61 @@
 //
 
 #include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <filesystem>
 #include <memory>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <utility>
 #include <boost/beast.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/signal_set.hpp>
 #include <botan/asio_stream.h>
 #include <botan/certstor_system.h>
 #include <botan/auto_rng.h>
+#include <botan/hash.h>
+#include <botan/x509path.h>
+#include <botan/x509self.h>
+#include <botan/ecdsa.h>
+#include <botan/cpuid.h>
 #include <string>
 #include <string_view>
 #include <vector>
-#include <boost/signals2.hpp>
+#include <span>
+#include <optional>
+#include <bit>
+#include <cmath>
+#include <array>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <ctime>
+#include <cctype>
+#include <cwchar>
+#include <map>
+#include <unordered_map>
+#include <list>
+#include <deque>
+#include <queue>
 #include <irrlicht.h>
 #include <exception>
 #include <functional>
+#include <new>
+#include <cstdlib>
+#include <sys/resource.h>
 #include <SFML/Audio.hpp>
+#include "embedded_media.hpp"
 
 namespace asio = boost::asio;
 namespace beast = boost::beast;
@@ -29,6 +71,190 @@ namespace TLS = Botan::TLS;
 using namespace std::string_literals;
 using namespace std::placeholders;
 
+// Counts operator new calls while enabled (--alloc-stats), so the callback
+// and the coroutine sessions can be compared per probe.
+class AllocationCounter {
+public:
+	static inline bool enabled = false; // Set by main() before any thread starts
+	static inline std::atomic<std::uint64_t> count = 0;
+};
+
+void * operator new(std::size_t size) {
+	if (AllocationCounter::enabled)
+		AllocationCounter::count.fetch_add(1, std::memory_order_relaxed);
+	if (void * pointer = std::malloc(size == 0 ? 1 : size))
+		return pointer;
+	throw std::bad_alloc{};
+}
+
+// Not inlined: g++ would otherwise take the free() of memory from this
+// operator new for a mismatch and warn at every delete.
+[[gnu::noinline]] void operator delete(void * pointer) noexcept {
+	std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void * pointer, std::size_t) noexcept {
+	std::free(pointer);
+}
+
+// Per-thread free lists for the storage of asynchronous operations. A
+// session stays on the io_context thread it started on, so a block is
+// nearly always returned to the thread that took it, and each thread only
+// ever touches its own lists, so no lock is needed. Once every size class
+// has warmed up, a probe step takes its memory from here instead of the
+// heap.
+class HandlerMemory {
+private:
+	static constexpr std::size_t smallest = 64;
+	static constexpr int classCount = 8; // 64 .. 8192 bytes
+	static constexpr std::size_t maxFree = 512; // Blocks kept per class and thread
+	struct Block {
+		Block * next;
+	};
+	struct Lists {
+		std::array<Block *, classCount> head{};
+		std::array<std::size_t, classCount> count{};
+		~Lists() {
+			for (Block * block: head)
+				while (block)
+					::operator delete(std::exchange(block, block->next));
+		}
+	};
+	static Lists & lists() {
+		thread_local Lists lists;
+		return lists;
+	}
+	static int sizeClass(std::size_t bytes) {
+		return std::bit_width((std::max(bytes, smallest) - 1) / smallest);
+	}
+	static inline std::atomic<std::uint64_t> freshCount = 0;
+	static inline std::atomic<std::uint64_t> recycledCount = 0;
+public:
+	static void * allocate(std::size_t bytes) {
+		const int index = sizeClass(bytes);
+		if (index >= classCount)
+			return ::operator new(bytes);
+		Lists & free = lists();
+		if (Block * block = free.head[index]) {
+			free.head[index] = block->next;
+			--free.count[index];
+			if (AllocationCounter::enabled)
+				recycledCount.fetch_add(1, std::memory_order_relaxed);
+			return block;
+		}
+		if (AllocationCounter::enabled)
+			freshCount.fetch_add(1, std::memory_order_relaxed);
+		return ::operator new(smallest << index);
+	}
+	static void deallocate(void * pointer, std::size_t bytes) noexcept {
+		const int index = sizeClass(bytes);
+		Lists & free = lists();
+		if (index >= classCount || free.count[index] >= maxFree)
+			return ::operator delete(pointer);
+		free.head[index] = new (pointer) Block{free.head[index]};
+		++free.count[index];
+	}
+	static std::uint64_t fresh() {
+		return freshCount;
+	}
+	static std::uint64_t recycled() {
+		return recycledCount;
+	}
+};
+
+template <typename T>
+class RecyclingAllocator {
+public:
+	using value_type = T;
+	RecyclingAllocator() noexcept = default;
+	template <typename U>
+	RecyclingAllocator(const RecyclingAllocator<U> &) noexcept {}
+	T * allocate(std::size_t n) {
+		return static_cast<T *>(HandlerMemory::allocate(n * sizeof(T)));
+	}
+	void deallocate(T * pointer, std::size_t n) noexcept {
+		HandlerMemory::deallocate(pointer, n * sizeof(T));
+	}
+	friend bool operator==(const RecyclingAllocator &, const RecyclingAllocator &) noexcept {
+		return true;
+	}
+	friend bool operator!=(const RecyclingAllocator &, const RecyclingAllocator &) noexcept {
+		return false;
+	}
+};
+
+// Gives a completion handler RecyclingAllocator as its associated
+// allocator, which asio and beast use for the operation state of every
+// layer below it.
+template <typename Handler>
+class RecyclingHandler {
+private:
+	Handler handler;
+public:
+	using allocator_type = RecyclingAllocator<void>;
+	explicit RecyclingHandler(Handler _handler_)
+	:
+		handler{std::move(_handler_)}
+	{
+	}
+	allocator_type get_allocator() const noexcept {
+		return {};
+	}
+	const Handler & wrapped() const noexcept {
+		return handler;
+	}
+	template <typename... Args>
+	void operator()(Args && ... args) {
+		handler(std::forward<Args>(args)...);
+	}
+};
+
+template <typename Handler>
+RecyclingHandler<std::decay_t<Handler>> recycled(Handler && handler) {
+	return RecyclingHandler<std::decay_t<Handler>>{std::forward<Handler>(handler)};
+}
+
+// Completion token that hands the operation a RecyclingHandler around the
+// handler the wrapped token makes, e.g. a coroutine's. Operations that
+// still use async_completion (Botan's stream) can be given the same
+// concrete handler through async_initiate.
+template <typename Token>
+struct RecyclingToken {
+	Token token;
+};
+
+template <typename Token>
+RecyclingToken<std::decay_t<Token>> recyclingToken(Token && token) {
+	return {std::forward<Token>(token)};
+}
+
+// A wrapped handler keeps the executor of the handler inside it.
+template <typename Handler, typename Executor>
+struct asio::associated_executor<RecyclingHandler<Handler>, Executor> {
+	using type = asio::associated_executor_t<Handler, Executor>;
+	static type get(const RecyclingHandler<Handler> & handler, const Executor & executor = Executor()) noexcept {
+		return asio::associated_executor<Handler, Executor>::get(handler.wrapped(), executor);
+	}
+};
+
+template <typename Token, typename Signature>
+struct asio::async_result<RecyclingToken<Token>, Signature> {
+	using return_type = typename asio::async_result<Token, Signature>::return_type;
+	template <typename Initiation, typename RawToken, typename... Args>
+	static return_type initiate(Initiation && initiation, RawToken && token, Args && ... args) {
+		return asio::async_initiate<Token, Signature>(
+			[initiation=std::forward<Initiation>(initiation)] (auto && handler, auto && ... args) mutable {
+				std::move(initiation)(
+					recycled(std::forward<decltype(handler)>(handler)),
+					std::forward<decltype(args)>(args)...
+				);
+			},
+			token.token,
+			std::forward<Args>(args)...
+		);
+	}
+};
+
 enum class Color: std::uint32_t {
 	Grey = 0xff141414, // Program Started
 	LightBlue = 0xff6762f3, // Host Resolved
@@ -49,24 +275,386 @@ enum {
 	barid_start,
 	barid_quit,
 	buttonid_start,
-	buttonid_quit
+	buttonid_quit,
+	scrollid_results
 };
 
 class DD final {};
 DD dd;
 
+// The system trust store, read once and indexed in memory by subject DN and
+// subject key ID. It is built on first use (or up front with
+// --prewarm-trust-store) and never changes afterwards, so all sessions on
+// all threads can read it without locking.
+class SharedTrustStore: public Botan::Certificate_Store {
+private:
+	using CertificatePtr = std::shared_ptr<const Botan::X509_Certificate>;
+	using KeyHash = std::vector<uint8_t>;
+	std::multimap<Botan::X509_DN, CertificatePtr> bySubject;
+	std::multimap<KeyHash, CertificatePtr> byKeyId;
+	std::map<KeyHash, CertificatePtr> byPublicKeySha1;
+	std::map<KeyHash, CertificatePtr> byRawSubjectSha256;
+	std::vector<Botan::X509_DN> subjects;
+	// Some platform stores can not be enumerated, those are only wrapped.
+	std::unique_ptr<Botan::System_Certificate_Store> unindexed;
+	std::size_t certificateCount = 0;
+	std::chrono::steady_clock::duration loadTime{};
+	SharedTrustStore() {
+		const auto begin = std::chrono::steady_clock::now();
+		auto systemStore = std::make_unique<Botan::System_Certificate_Store>();
+		try {
+			for (const auto & subject: systemStore->all_subjects())
+				for (const auto & certificate: systemStore->find_all_certs(subject, {}))
+					this->add(certificate);
+		} catch (Botan::Exception & exc) {
+			std::cerr << "[Trust Store] can not enumerate system store, using it unindexed: "
+				<< exc.what() << std::endl;
+			bySubject.clear();
+			byKeyId.clear();
+			byPublicKeySha1.clear();
+			byRawSubjectSha256.clear();
+			subjects.clear();
+			certificateCount = 0;
+			unindexed = std::move(systemStore);
+		}
+		loadTime = std::chrono::steady_clock::now() - begin;
+	}
+	void add(const CertificatePtr & certificate) {
+		const Botan::X509_DN & subject = certificate->subject_dn();
+		if (bySubject.find(subject) == bySubject.end())
+			subjects.push_back(subject);
+		bySubject.emplace(subject, certificate);
+		if (!certificate->subject_key_id().empty())
+			byKeyId.emplace(certificate->subject_key_id(), certificate);
+		byPublicKeySha1.emplace(certificate->subject_public_key_bitstring_sha1(), certificate);
+		byRawSubjectSha256.emplace(certificate->raw_subject_dn_sha256(), certificate);
+		++certificateCount;
+	}
+public:
+	static SharedTrustStore & instance() {
+		static SharedTrustStore store;
+		return store;
+	}
+	std::size_t size() const {
+		return certificateCount;
+	}
+	std::chrono::steady_clock::duration buildTime() const {
+		return loadTime;
+	}
+	// Same matching rules as Botan's stores: the subject DN must match, and a
+	// certificate that has a subject key ID must match the wanted key ID.
+	std::vector<CertificatePtr> find_all_certs(
+		const Botan::X509_DN & subjectDn,
+		const KeyHash & keyId
+	) const override {
+		if (unindexed)
+			return unindexed->find_all_certs(subjectDn, keyId);
+		std::vector<CertificatePtr> found;
+		auto [first, last] = bySubject.equal_range(subjectDn);
+		for (auto iter = first; iter != last; ++iter) {
+			const KeyHash & subjectKeyId = iter->second->subject_key_id();
+			if (keyId.empty() || subjectKeyId.empty() || subjectKeyId == keyId)
+				found.push_back(iter->second);
+		}
+		return found;
+	}
+	CertificatePtr find_cert(
+		const Botan::X509_DN & subjectDn,
+		const KeyHash & keyId
+	) const override {
+		if (unindexed)
+			return unindexed->find_cert(subjectDn, keyId);
+		if (!keyId.empty()) {
+			auto [first, last] = byKeyId.equal_range(keyId);
+			for (auto iter = first; iter != last; ++iter)
+				if (iter->second->subject_dn() == subjectDn)
+					return iter->second;
+		}
+		auto found = this->find_all_certs(subjectDn, keyId);
+		return found.empty() ? nullptr : found.front();
+	}
+	CertificatePtr find_cert_by_pubkey_sha1(const KeyHash & keyHash) const override {
+		if (unindexed)
+			return unindexed->find_cert_by_pubkey_sha1(keyHash);
+		auto iter = byPublicKeySha1.find(keyHash);
+		return iter == byPublicKeySha1.end() ? nullptr : iter->second;
+	}
+	CertificatePtr find_cert_by_raw_subject_dn_sha256(const KeyHash & subjectHash) const override {
+		if (unindexed)
+			return unindexed->find_cert_by_raw_subject_dn_sha256(subjectHash);
+		auto iter = byRawSubjectSha256.find(subjectHash);
+		return iter == byRawSubjectSha256.end() ? nullptr : iter->second;
+	}
+	std::vector<Botan::X509_DN> all_subjects() const override {
+		if (unindexed)
+			return unindexed->all_subjects();
+		return subjects;
+	}
+};
+
+// Remembers certificate chains that passed path validation. The key is a
+// hash over the hostname, the validation policy and every certificate of the
+// chain, so only an identical chain for the same host is a hit. An entry
+// lives until the earliest notAfter of its chain or the TTL, whichever comes
+// first. Failed validations are never cached.
+class VerifiedChainCache {
+private:
+	using Key = std::vector<uint8_t>;
+	struct Entry {
+		std::chrono::system_clock::time_point expires;
+		std::list<Key>::iterator age;
+	};
+	static inline std::size_t capacity = 4096;
+	static inline std::chrono::seconds timeToLive{300};
+	std::mutex mutex;
+	std::map<Key, Entry> entries;
+	std::list<Key> ages; // Most recently used first
+	std::atomic<std::size_t> hitCount = 0;
+	std::atomic<std::size_t> missCount = 0;
+public:
+	// Must be called before the first instance(), 0 disables the cache.
+	static void configure(std::size_t maxChains, std::chrono::seconds ttl) {
+		capacity = maxChains;
+		timeToLive = ttl;
+	}
+	static bool enabled() {
+		return capacity > 0;
+	}
+	static VerifiedChainCache & instance() {
+		static VerifiedChainCache cache;
+		return cache;
+	}
+	std::size_t hits() const {
+		return hitCount;
+	}
+	std::size_t misses() const {
+		return missCount;
+	}
+	// Matches TLS::Context::Verify_Callback_T, does what Botan's default
+	// TLS::Callbacks::tls_verify_cert_chain does on a miss.
+	void verify(
+		const std::vector<Botan::X509_Certificate> & chain,
+		const std::vector<std::shared_ptr<const Botan::OCSP::Response>> & ocspResponses,
+		const std::vector<Botan::Certificate_Store *> & trustedRoots,
+		Botan::Usage_Type usage,
+		const std::string & hostname,
+		const TLS::Policy & policy
+	) {
+		if (chain.empty())
+			throw TLS::TLS_Exception{TLS::Alert::BAD_CERTIFICATE, "Certificate chain was empty"};
+		const auto now = std::chrono::system_clock::now();
+		Key key = this->makeKey(chain, usage, hostname, policy);
+		if (this->lookup(key, now)) {
+			++hitCount;
+			return;
+		}
+		++missCount;
+		const Botan::Path_Validation_Restrictions restrictions{
+			policy.require_cert_revocation_info(),
+			policy.minimum_signature_strength()
+		};
+		const Botan::Path_Validation_Result result = Botan::x509_path_validate(
+			chain,
+			restrictions,
+			trustedRoots,
+			usage == Botan::Usage_Type::TLS_SERVER_AUTH ? hostname : "",
+			usage,
+			now,
+			std::chrono::milliseconds{0},
+			ocspResponses
+		);
+		if (!result.successful_validation())
+			throw TLS::TLS_Exception{
+				TLS::Alert::BAD_CERTIFICATE,
+				"Certificate validation failure: " + result.result_string()
+			};
+		auto expires = now + timeToLive;
+		for (const auto & certificate: chain)
+			expires = std::min(expires, certificate.not_after().to_std_timepoint());
+		this->insert(std::move(key), expires);
+	}
+private:
+	Key makeKey(
+		const std::vector<Botan::X509_Certificate> & chain,
+		Botan::Usage_Type usage,
+		const std::string & hostname,
+		const TLS::Policy & policy
+	) const {
+		auto hash = Botan::HashFunction::create_or_throw("SHA-256");
+		hash->update(hostname);
+		hash->update(static_cast<uint8_t>(usage));
+		hash->update(static_cast<uint8_t>(policy.require_cert_revocation_info()));
+		hash->update(static_cast<uint8_t>(policy.minimum_signature_strength()));
+		for (const auto & certificate: chain)
+			hash->update(certificate.BER_encode());
+		return hash->final_stdvec();
+	}
+	bool lookup(const Key & key, std::chrono::system_clock::time_point now) {
+		std::lock_guard lock{mutex};
+		auto iter = entries.find(key);
+		if (iter == entries.end())
+			return false;
+		if (iter->second.expires <= now) {
+			ages.erase(iter->second.age);
+			entries.erase(iter);
+			return false;
+		}
+		ages.splice(ages.begin(), ages, iter->second.age);
+		return true;
+	}
+	void insert(Key && key, std::chrono::system_clock::time_point expires) {
+		std::lock_guard lock{mutex};
+		auto iter = entries.find(key);
+		if (iter != entries.end()) {
+			iter->second.expires = expires;
+			ages.splice(ages.begin(), ages, iter->second.age);
+			return;
+		}
+		if (entries.size() >= capacity) {
+			entries.erase(ages.back());
+			ages.pop_back();
+		}
+		ages.push_front(key);
+		entries.emplace(std::move(key), Entry{expires, ages.begin()});
+	}
+};
+
 class CredentialsManager: public Botan::Credentials_Manager {
 private:
-	Botan::System_Certificate_Store systemCertificateStore;
+	// Trust anchors from --ca-file, such as the standin server's CA. Only
+	// filled before any session starts.
+	static Botan::Certificate_Store_In_Memory & extraAnchors() {
+		static Botan::Certificate_Store_In_Memory store;
+		return store;
+	}
+	static inline bool haveExtraAnchors = false;
 public:
+	static void addTrustAnchor(const std::string & file) {
+		extraAnchors().add_certificate(Botan::X509_Certificate{file});
+		haveExtraAnchors = true;
+	}
 	std::vector<Botan::Certificate_Store *> trusted_certificate_authorities(
 		const std::string &,
 		const std::string &
 	) override {
-		return {&systemCertificateStore};
+		if (haveExtraAnchors)
+			return {&SharedTrustStore::instance(), &extraAnchors()};
+		return {&SharedTrustStore::instance()};
 	}
 };
 
+// One TLS session cache for the whole process, keyed by
+// TLS::Server_Information, so a repeated probe of the same host resumes
+// instead of paying for a full handshake. Botan's in-memory manager is
+// bounded and does its own locking, so all io_context threads can share it.
+class SharedSessionCache {
+private:
+	static inline std::size_t capacity = 10000;
+	Botan::AutoSeeded_RNG rng;
+	std::unique_ptr<TLS::Session_Manager> manager;
+	SharedSessionCache() {
+		if (capacity == 0)
+			manager = std::make_unique<TLS::Session_Manager_Noop>();
+		else
+			manager = std::make_unique<TLS::Session_Manager_In_Memory>(rng, capacity);
+	}
+public:
+	// Must be called before the first instance(), 0 disables resumption.
+	static void setCapacity(std::size_t maxSessions) {
+		capacity = maxSessions;
+	}
+	static TLS::Session_Manager & instance() {
+		static SharedSessionCache cache;
+		return *cache.manager;
+	}
+};
+
+// Per session view of the shared cache. Up to TLS 1.2 Botan saves a session
+// at the end of every full handshake, so a cached session that was offered
+// without a new one being saved means the handshake was resumed. A TLS 1.3
+// ticket only arrives after the handshake, resumed or not, and TLS::Stream
+// does not tell whether the server took the offered one, so that case stays
+// unknown.
+class SessionCacheView: public TLS::Session_Manager {
+public:
+	enum class Resumption {
+		Full,
+		Resumed,
+		Unknown // A TLS 1.3 session was offered
+	};
+private:
+	TLS::Session_Manager & shared;
+	bool offered = false;
+	bool saved = false;
+	std::uint16_t offeredVersion = 0;
+	std::uint16_t versionCode = 0; // Of the session offered or saved
+public:
+	explicit SessionCacheView(TLS::Session_Manager & shared)
+	:
+		shared{shared}
+	{
+	}
+	bool load_from_session_id(
+		const std::vector<uint8_t> & sessionId,
+		TLS::Session & session
+	) override {
+		return shared.load_from_session_id(sessionId, session);
+	}
+	bool load_from_server_info(
+		const TLS::Server_Information & info,
+		TLS::Session & session
+	) override {
+		const bool found = shared.load_from_server_info(info, session);
+		offered = offered || found;
+		if (found)
+			offeredVersion = versionCode = session.version().version_code();
+		return found;
+	}
+	void remove_entry(const std::vector<uint8_t> & sessionId) override {
+		shared.remove_entry(sessionId);
+	}
+	std::size_t remove_all() override {
+		return shared.remove_all();
+	}
+	void save(const TLS::Session & session) override {
+		saved = true;
+		versionCode = session.version().version_code();
+		shared.save(session);
+	}
+	std::chrono::seconds session_lifetime() const override {
+		return shared.session_lifetime();
+	}
+	// Only meaningful right after the handshake.
+	Resumption resumption() const {
+		if (!offered || saved)
+			return Resumption::Full;
+		if (offeredVersion >= TLS::Protocol_Version::TLS_V13)
+			return Resumption::Unknown;
+		return Resumption::Resumed;
+	}
+	static const char * resumptionString(Resumption resumption) {
+		switch (resumption) {
+		case Resumption::Full:
+			return "full";
+		case Resumption::Resumed:
+			return "resumed";
+		default:
+			return "unknown";
+		}
+	}
+	// Botan's Protocol_Version code of the connection, 0 until a session
+	// was offered or saved (a TLS 1.3 ticket may only arrive after the
+	// handshake).
+	std::uint16_t version() const {
+		return versionCode;
+	}
+};
+
+// Session status bus. Every session publishes to its own Topic, and each
+// consumer owns a Mailbox that it drains from its own loop, so the network
+// threads never wait for a window or for the console. A Topic delivers to
+// its own few subscribers and to the consumers listening to every session;
+// sessions nobody listens to cost one pass over two small empty arrays.
 class SigMan {
 public:
 	enum class NetStat {
@@ -76,9 +664,8 @@ public:
 		Handshaked,
 		Requested,
 		Got,
-		PleaseClose,
 		NetworkException,
-		CppGeneralException
+		CppGeneralException // Stays last, ProbeResult::reachedAt is sized by it
 	};
 	static std::string NetStatusString(SigMan::NetStat stat) {
 		if (stat == NetStat::ProgramStarted)
@@ -93,60 +680,371 @@ public:
 			return "SigMan::NetStat::Requested";
 		else if (stat == NetStat::Got)
 			return "SigMan::NetStat::Got";
-		else if (stat == NetStat::PleaseClose)
-			return "SigMan::NetStat::PleaseClose";
 		else if (stat == NetStat::NetworkException)
 			return "SigMan::NetStat::NetworkException";
 		else if (stat == NetStat::CppGeneralException)
 			return "SigMan::NetStat::CppGeneralException";
 		return "UndefinedError";
 	}
+	// The last event of a session, nothing is published for it afterwards.
+	static bool finalStat(NetStat stat) {
+		return stat == NetStat::Got || stat == NetStat::NetworkException || stat == NetStat::CppGeneralException;
+	}
 public:
-	using SignalType = boost::signals2::signal<void(SigMan::NetStat)>;
-	using SlotType = SignalType::slot_type;
-	using ConnectionType = boost::signals2::connection;
+	struct Event {
+		std::uint64_t session = 0;
+		NetStat stat = NetStat::ProgramStarted;
+		std::chrono::steady_clock::time_point time;
+		beast::error_code error;
+	};
+	// Bounded multi-producer single-consumer queue (Vyukov's bounded
+	// queue with a plain consumer index). push() never waits: when the
+	// consumer falls behind, a progress event is dropped and counted, but
+	// a session's final event goes to an unbounded overflow list, so the
+	// consumer always learns how every session ended.
+	class Mailbox {
+	public:
+		static constexpr std::size_t capacity = 1024;
+	private:
+		struct Cell {
+			std::atomic<std::size_t> sequence;
+			Event event;
+		};
+		struct Overflow {
+			Event event;
+			Overflow * next;
+		};
+		std::unique_ptr<Cell[]> cells{new Cell[capacity]};
+		alignas(64) std::atomic<std::size_t> enqueuePos = 0;
+		alignas(64) std::size_t dequeuePos = 0;
+		std::atomic<std::size_t> droppedCount = 0;
+		std::atomic<Overflow *> overflow = nullptr; // Newest first
+		Overflow * overflowTaken = nullptr; // Consumer side, oldest first
+	public:
+		Mailbox() {
+			for (std::size_t i=0; i<capacity; ++i)
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+		Mailbox(const Mailbox &) = delete;
+		Mailbox & operator=(const Mailbox &) = delete;
+		~Mailbox() {
+			Event event;
+			while (this->pop(event))
+				;
+		}
+		bool push(const Event & event) noexcept {
+			std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell & cell = cells[pos & (capacity - 1)];
+				const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+				if (diff == 0) {
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						cell.event = event;
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (diff < 0) {
+					return this->pushOverflow(event);
+				} else {
+					pos = enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+		// Consumer side, one thread at a time. The overflow is only read
+		// once the ring is empty, so a final event never overtakes an
+		// earlier event of its session.
+		bool pop(Event & event) noexcept {
+			Cell & cell = cells[dequeuePos & (capacity - 1)];
+			const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			if (static_cast<std::ptrdiff_t>(sequence - (dequeuePos + 1)) < 0)
+				return this->popOverflow(event);
+			event = cell.event;
+			cell.sequence.store(dequeuePos + capacity, std::memory_order_release);
+			++dequeuePos;
+			return true;
+		}
+		std::size_t dropped() const {
+			return droppedCount.load(std::memory_order_relaxed);
+		}
+	private:
+		bool pushOverflow(const Event & event) noexcept {
+			if (!SigMan::finalStat(event.stat)) {
+				droppedCount.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			Overflow * node = new Overflow{event, overflow.load(std::memory_order_relaxed)};
+			while (!overflow.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+				;
+			return true;
+		}
+		bool popOverflow(Event & event) noexcept {
+			if (overflowTaken == nullptr) {
+				Overflow * node = overflow.exchange(nullptr, std::memory_order_acquire);
+				while (node != nullptr) {
+					Overflow * next = node->next;
+					node->next = overflowTaken;
+					overflowTaken = node;
+					node = next;
+				}
+				if (overflowTaken == nullptr)
+					return false;
+			}
+			Overflow * node = overflowTaken;
+			event = node->event;
+			overflowTaken = node->next;
+			delete node;
+			return true;
+		}
+	};
+	static constexpr std::size_t maxSubscribers = 4;
+private:
+	// A fixed array of mailbox pointers plus a count of publishers that
+	// may be reading it. Unsubscribing clears the slot, then waits for the
+	// publishers already past it, so a mailbox is never written after its
+	// owner has left.
+	class Subscribers {
+	private:
+		std::array<std::atomic<Mailbox *>, maxSubscribers> slots{};
+		std::atomic<std::size_t> subscribed = 0;
+		std::atomic<int> publishing = 0;
+	public:
+		void add(Mailbox & mailbox) {
+			for (auto & slot: slots) {
+				Mailbox * expected = nullptr;
+				if (slot.compare_exchange_strong(expected, &mailbox)) {
+					++subscribed;
+					return;
+				}
+			}
+			throw std::runtime_error{"SigMan: too many subscribers"};
+		}
+		void remove(Mailbox & mailbox) {
+			for (auto & slot: slots) {
+				Mailbox * expected = &mailbox;
+				if (slot.compare_exchange_strong(expected, nullptr)) {
+					--subscribed;
+					break;
+				}
+			}
+			while (publishing.load() != 0)
+				std::this_thread::yield();
+		}
+		void deliver(const Event & event) noexcept {
+			if (subscribed.load(std::memory_order_relaxed) == 0)
+				return;
+			++publishing;
+			for (auto & slot: slots)
+				if (Mailbox * mailbox = slot.load())
+					mailbox->push(event);
+			--publishing;
+		}
+	};
+public:
+	// One session's channel, shared by the session and whoever watches it.
+	class Topic {
+	private:
+		SigMan & sigMan;
+		const std::uint64_t sessionId;
+		Subscribers subscribers;
+	public:
+		Topic(SigMan & _sigMan_, std::uint64_t _sessionId_)
+		:
+			sigMan{_sigMan_},
+			sessionId{_sessionId_}
+		{
+		}
+		std::uint64_t id() const {
+			return sessionId;
+		}
+		void subscribe(Mailbox & mailbox) {
+			subscribers.add(mailbox);
+		}
+		void unsubscribe(Mailbox & mailbox) {
+			subscribers.remove(mailbox);
+		}
+		void publish(NetStat stat, beast::error_code error = {}) noexcept {
+			const Event event{sessionId, stat, std::chrono::steady_clock::now(), error};
+			subscribers.deliver(event);
+			sigMan.everySession.deliver(event);
+		}
+	};
 private:
-	SignalType sig;
+	Subscribers everySession;
+	std::atomic<std::uint64_t> nextSession = 1;
 public:
-	ConnectionType connect(const SlotType & slot) {
-		return sig.connect(slot);
+	std::shared_ptr<Topic> createTopic() {
+		return std::make_shared<Topic>(*this, nextSession.fetch_add(1, std::memory_order_relaxed));
 	}
-	void update(SigMan::NetStat status) {
-		this->sig(status);
+	void subscribe(Mailbox & mailbox) {
+		everySession.add(mailbox);
+	}
+	void unsubscribe(Mailbox & mailbox) {
+		everySession.remove(mailbox);
 	}
 };
 
+// Base of the bus consumers: owns the mailbox and the subscription, and
+// hands queued events to update() whenever the owner calls pump().
 class MessageTarget {
-protected:
-	SigMan::ConnectionType conn;
+private:
+	SigMan::Mailbox mailbox;
+	SigMan * allSessions = nullptr;
+	std::shared_ptr<SigMan::Topic> topic;
 public:
-	virtual void update(SigMan::NetStat status) = 0;
+	virtual void update(const SigMan::Event & event) = 0;
 	void attach(SigMan & sigMan) {
-		conn = sigMan.connect(
-			std::bind(
-				&MessageTarget::update,
-				this,
-				_1
-			)
-		);
+		sigMan.subscribe(mailbox);
+		allSessions = &sigMan;
+	}
+	void attach(std::shared_ptr<SigMan::Topic> _topic_) {
+		_topic_->subscribe(mailbox);
+		topic = std::move(_topic_);
 	}
 	void detach() {
-		conn.disconnect();
+		if (allSessions)
+			allSessions->unsubscribe(mailbox);
+		if (topic)
+			topic->unsubscribe(mailbox);
+		allSessions = nullptr;
+		topic.reset();
+	}
+	void pump() {
+		SigMan::Event event;
+		while (mailbox.pop(event))
+			this->update(event);
+	}
+	std::size_t dropped() const {
+		return mailbox.dropped();
 	}
 	virtual ~MessageTarget() {}
 };
 
+// Prints every session's status changes from a thread of its own.
 class PrintMessage: private MessageTarget {
+private:
+	std::atomic<bool> running = true;
+	std::thread printer;
 public:
 	PrintMessage(SigMan & sigMan) {
 		this->attach(sigMan);
+		printer = std::thread{[this] {
+			while (running) {
+				this->pump();
+				std::this_thread::sleep_for(std::chrono::milliseconds{50});
+			}
+			this->pump();
+		}};
 	}
 	~PrintMessage() {
 		this->detach();
+		running = false;
+		printer.join();
+		if (this->dropped() != 0)
+			std::cout << "SigMan: " << this->dropped() << " status messages dropped" << std::endl;
+	}
+	void update(const SigMan::Event & event) override {
+		std::cout << "SigMan::NetStat (session " << event.session << "):" << std::endl;
+		std::cout << '\t' << SigMan::NetStatusString(event.stat);
+		if (event.error)
+			std::cout << ": " << event.error.message();
+		std::cout << std::endl;
+	}
+};
+
+// A fixed set of io_contexts, one thread each (normally one per core).
+// Sessions are placed on the least loaded io_context, ties go round-robin,
+// so the number of threads stays flat no matter how many sessions run.
+class IoContextPool {
+public:
+	class Slot {
+	private:
+		friend class IoContextPool;
+		asio::io_context ioContext{1};
+		asio::executor_work_guard<asio::io_context::executor_type> work{ioContext.get_executor()};
+		std::atomic<std::size_t> active = 0;
+		std::atomic<std::size_t> completed = 0;
+	public:
+		asio::io_context & context() {
+			return ioContext;
+		}
+		// Every acquire() must be paired with exactly one release().
+		void release() {
+			--active;
+			++completed;
+		}
+	};
+private:
+	std::vector<std::unique_ptr<Slot>> slots;
+	std::vector<std::thread> threads;
+	std::atomic<std::size_t> cursor = 0;
+public:
+	explicit IoContextPool(std::size_t size) {
+		if (size == 0)
+			size = 1;
+		for (std::size_t i=0; i<size; ++i)
+			slots.push_back(std::make_unique<Slot>());
+	}
+	~IoContextPool() {
+		this->join();
+	}
+	IoContextPool(const IoContextPool &) = delete;
+	IoContextPool & operator=(const IoContextPool &) = delete;
+	std::size_t size() const {
+		return slots.size();
+	}
+	void run() {
+		for (auto & slot: slots)
+			threads.emplace_back([&ioContext = slot->ioContext] { ioContext.run(); });
+	}
+	// The io_context of one slot, for work that is not a session.
+	asio::io_context & context(std::size_t index) {
+		return slots[index % slots.size()]->ioContext;
 	}
-	void update(SigMan::NetStat status) override {
-		std::cout << "SigMan::NetStat:" << std::endl;
-		std::cout << '\t' << SigMan::NetStatusString(status) << std::endl;
+	Slot & acquire() {
+		return this->leastLoaded(cursor++);
+	}
+	// Like acquire(), but the search starts at the io_context the key hashes
+	// to. A host probed one session at a time keeps going to the same
+	// io_context and finds its pooled connections there again; a busy host
+	// spreads over every io_context, each keeping its own ConnectionPool.
+	Slot & acquireFor(const std::string & key) {
+		return this->leastLoaded(std::hash<std::string>{}(key));
+	}
+	// Lets the threads return once their pending work is done.
+	void join() {
+		for (auto & slot: slots)
+			slot->work.reset();
+		for (auto & thread: threads)
+			if (thread.joinable())
+				thread.join();
+	}
+	// Abandons pending work, used when the program is closing.
+	void stop() {
+		for (auto & slot: slots)
+			slot->ioContext.stop();
+		this->join();
+	}
+	void printStats(std::ostream & out, std::chrono::duration<double> elapsed) const {
+		for (std::size_t i=0; i<slots.size(); ++i) {
+			const std::size_t completed = slots[i]->completed;
+			out << "io_context #" << i << ": " << completed << " sessions, "
+				<< (elapsed.count() > 0 ? completed / elapsed.count() : 0.0)
+				<< " sessions/s" << std::endl;
+		}
+	}
+private:
+	Slot & leastLoaded(std::size_t start) {
+		const std::size_t count = slots.size();
+		const std::size_t first = start % count;
+		Slot * best = slots[first].get();
+		for (std::size_t i=1; i<count && best->active > 0; ++i) {
+			Slot * slot = slots[(first + i) % count].get();
+			if (slot->active < best->active)
+				best = slot;
+		}
+		++best->active;
+		return *best;
 	}
 };
 
@@ -162,102 +1060,1039 @@ public:
 	}
 };
 
-template <typename IrrlichtWindow>
-class Event: public irr::IEventReceiver, private MessageTarget {
-private:
-	IrrlichtWindow & window;
+// Decides when a window loop draws. A frame is drawn only after something
+// marked the window dirty (input, a GUI event, a session colour change) and
+// at most maxFps times a second; otherwise the loop sleeps instead of
+// redrawing an unchanged scene with the software rasterizer. A heartbeat
+// redraws now and then anyway, for the blinking edit box cursor and for
+// window systems that drop the contents of a covered window. A minimized
+// window is never drawn.
+class FramePacer {
 private:
-	irr::IrrlichtDevice * device;
-	irr::video::IVideoDriver * driver;
-	irr::scene::ISceneManager * smgr;
-	irr::gui::IGUIEnvironment * igui;
-	bool attached = false;
-	std::future<void> sessionThread;
-	std::atomic<bool> sessionRunning = false;
-
-	irr::gui::IGUIEditBox * hostBox = nullptr;
-	irr::gui::IGUIEditBox * portBox = nullptr;
-
-	sf::Sound sound;
-	sf::SoundBuffer soundBuffer;
-	bool audioLoaded = false;
+	static inline unsigned maxFps = 30;
+	static inline std::chrono::milliseconds idleSleep{20};
+	std::atomic<bool> dirty = true;
+	std::chrono::steady_clock::time_point lastFrame{};
+	const std::chrono::milliseconds heartbeat;
 public:
-	Event(
-		IrrlichtWindow & window,
-		SigMan & sigMan
-	) noexcept
+	explicit FramePacer(std::chrono::milliseconds _heartbeat_)
 	:
-		window{window},
-		device{nullptr}
+		heartbeat{_heartbeat_}
 	{
-		this->attach(sigMan);
-		audioLoaded = soundBuffer.loadFromFile("./media/audio/click.ogg");
-		if (audioLoaded)
-			sound.setBuffer(soundBuffer);
 	}
-	~Event() {
-		this->detach();
+	// Must be called before any window opens, fps 0 removes the cap.
+	static void configure(unsigned fps, std::chrono::milliseconds idle) {
+		maxFps = fps;
+		idleSleep = idle;
 	}
-	void attachDevice() {
-		if (!window.opened)
-			throw std::runtime_error{"Attach Event to Window Error: because window is not opened!"};
-		device = window.device;
-		device->setEventReceiver(this);
-		attached = true;
-		driver = device->getVideoDriver();
-		smgr = device->getSceneManager();
-		igui = device->getGUIEnvironment();
+	void markDirty() {
+		dirty = true;
 	}
-	void update(SigMan::NetStat stat) override {
-		if (stat == SigMan::NetStat::PleaseClose) {
-			std::cout << "\"class Event\" Received PleaseClose:\n\t"
-				<< SigMan::NetStatusString(stat)
-				<< std::endl;
-			sessionRunning = false;
-			sessionThread = {};
+	// True when a frame should be drawn now, otherwise it has slept a bit.
+	bool frameDue(bool visible) {
+		const auto now = std::chrono::steady_clock::now();
+		const std::chrono::steady_clock::duration frameTime = maxFps > 0
+			? std::chrono::steady_clock::duration{std::chrono::seconds{1}} / maxFps
+			: std::chrono::steady_clock::duration::zero();
+		const bool wanted = visible && (dirty || now - lastFrame >= heartbeat);
+		if (wanted && now - lastFrame >= frameTime) {
+			dirty = false;
+			lastFrame = now;
+			return true;
 		}
+		if (wanted)
+			std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(lastFrame + frameTime - now, idleSleep));
+		else
+			std::this_thread::sleep_for(idleSleep);
+		return false;
 	}
-	void playClick() {
-		if (audioLoaded)
-			sound.play();
+};
+
+// The media files, compiled into the binary as embedded_media.hpp (written
+// by the embed tool from ./media at build time). With --media DIR a file of
+// the same name under DIR is used instead, read from disk once. Files can
+// be asked for as "audio/click.ogg" or just "click.ogg", and their bytes
+// stay valid for the rest of the program. Sound buffers are decoded once
+// and shared by everyone who plays them.
+class AssetCache {
+private:
+	static inline std::filesystem::path overrideDir; // Empty: embedded files only
+	std::mutex mutex;
+	std::map<std::string, std::optional<std::string>, std::less<>> fromDisk; // nullopt: not on disk
+	std::map<std::string, std::shared_ptr<const sf::SoundBuffer>, std::less<>> sounds;
+	AssetCache() = default;
+public:
+	// Must be called before the first instance().
+	static void configure(std::filesystem::path dir) {
+		overrideDir = std::move(dir);
 	}
-	bool OnEvent(const irr::SEvent & event) override {
-		switch (event.EventType) {
-		case irr::EET_KEY_INPUT_EVENT:
-			this->processKey(event);
-			break;
-		case irr::EET_GUI_EVENT:
-			this->processGUIEvent(event);
-			break;
-		default:
-			break;
+	static AssetCache & instance() {
+		static AssetCache cache;
+		return cache;
+	}
+	// Empty when there is no such file.
+	std::span<const char> bytes(std::string_view name) {
+		const embeddedMedia::File * embedded = AssetCache::find(name);
+		if (!overrideDir.empty()) {
+			const std::string relative{embedded ? embedded->name : AssetCache::trimmed(name)};
+			std::lock_guard lock{mutex};
+			auto iter = fromDisk.find(relative);
+			if (iter == fromDisk.end()) {
+				std::optional<std::string> contents;
+				if (std::ifstream in{overrideDir / relative, std::ios::binary}) {
+					std::ostringstream read;
+					read << in.rdbuf();
+					contents = std::move(read).str();
+				}
+				iter = fromDisk.emplace(relative, std::move(contents)).first;
+			}
+			if (iter->second)
+				return {iter->second->data(), iter->second->size()};
 		}
-		return false;
+		if (!embedded)
+			return {};
+		return {reinterpret_cast<const char *>(embedded->bytes.data()), embedded->bytes.size()};
 	}
-	inline void processKey(const irr::SEvent & event) {
-		if (event.KeyInput.PressedDown)
-			return;
-		switch (event.KeyInput.Key) {
-		case irr::KEY_KEY_Q:
-			window.opened = false;
-			this->attached = false;
-			device->closeDevice();
-			std::cout << "MainWindow is closed!" << std::endl;
-			break;
-		default:
-			break;
+	// nullptr when the file is missing or can not be decoded.
+	std::shared_ptr<const sf::SoundBuffer> sound(std::string_view name) {
+		{
+			std::lock_guard lock{mutex};
+			if (auto iter = sounds.find(name); iter != sounds.end())
+				return iter->second;
 		}
+		const auto data = this->bytes(name);
+		auto buffer = std::make_shared<sf::SoundBuffer>();
+		if (data.empty() || !buffer->loadFromMemory(data.data(), data.size()))
+			buffer.reset();
+		std::lock_guard lock{mutex};
+		return sounds.try_emplace(std::string{name}, std::move(buffer)).first->second;
 	}
-	inline void processGUIEvent(const irr::SEvent & event) {
-		switch (event.GUIEvent.EventType) {
-		case irr::gui::EGET_MENU_ITEM_SELECTED:
-			this->playClick();
-			this->processMenuItemSelected(event);
-			break;
-		case irr::gui::EGET_BUTTON_CLICKED:
-			this->playClick();
-			this->processButtonClicked(event);
-			break;
+private:
+	static std::string_view trimmed(std::string_view name) {
+		while (name.starts_with("./"))
+			name.remove_prefix(2);
+		if (name.starts_with("media/"))
+			name.remove_prefix(6);
+		return name;
+	}
+	static const embeddedMedia::File * find(std::string_view name) {
+		name = AssetCache::trimmed(name);
+		for (const auto & file: embeddedMedia::files)
+			if (file.name == name)
+				return &file;
+		const auto slash = name.find_last_of("/\\");
+		if (slash != std::string_view::npos)
+			name.remove_prefix(slash + 1);
+		for (const auto & file: embeddedMedia::files)
+			if (file.name.substr(file.name.find_last_of('/') + 1) == name)
+				return &file;
+		return nullptr;
+	}
+};
+
+// Hands the media files to Irrlicht's file system in place of the ./media
+// folder archive, so fonts and textures asked for by name come from
+// AssetCache and the program runs from any directory.
+class MediaArchive: public irr::io::IFileArchive {
+private:
+	irr::io::IFileSystem * fs;
+	irr::io::IFileList * fileList;
+public:
+	explicit MediaArchive(irr::io::IFileSystem * _fs_)
+	:
+		fs{_fs_},
+		fileList{_fs_->createEmptyFileList("", true, true)}
+	{
+		for (const auto & file: embeddedMedia::files)
+			fileList->addItem(
+				std::string{file.name}.c_str(),
+				0,
+				static_cast<irr::u32>(file.bytes.size()),
+				false,
+				static_cast<irr::u32>(&file - embeddedMedia::files)
+			);
+		fileList->sort();
+	}
+	~MediaArchive() {
+		fileList->drop();
+	}
+	irr::io::IReadFile * createAndOpenFile(const irr::io::path & filename) override {
+		const auto data = AssetCache::instance().bytes(filename.c_str());
+		if (data.empty())
+			return nullptr;
+		return fs->createMemoryReadFile(data.data(), static_cast<irr::s32>(data.size()), filename, false);
+	}
+	irr::io::IReadFile * createAndOpenFile(irr::u32 index) override {
+		if (index >= fileList->getFileCount())
+			return nullptr;
+		return this->createAndOpenFile(fileList->getFullFileName(index));
+	}
+	const irr::io::IFileList * getFileList() const override {
+		return fileList;
+	}
+};
+
+// Only the hardware drivers are known to draw 2D vertex lists. With the
+// software ones the dashboard and the latency chart draw one rectangle or
+// line per primitive instead.
+bool drawsVertexLists(irr::video::IVideoDriver * driver) {
+	const irr::video::E_DRIVER_TYPE type = driver->getDriverType();
+	return type == irr::video::EDT_OPENGL || type == irr::video::EDT_DIRECT3D9;
+}
+
+// Every session started from the main window as one tile of a grid,
+// coloured by the session's latest NetStat. The tiles are drawn by the main
+// window's own device as part of its frame: all of them as quads of one
+// vertex list in a single draw call (a rectangle each on the software
+// drivers), plus a label where the tiles are large enough, with no GUI
+// element or device per session. The quads are only rebuilt when a tile
+// changed. Events of all sessions arrive in one mailbox that the window
+// loop drains, so only that thread touches the tiles.
+class SessionDashboard: private MessageTarget {
+public:
+	static constexpr std::size_t maxTiles = 1024; // The oldest finished sessions make room
+private:
+	static constexpr irr::s32 headerHeight = 24;
+	struct Tile {
+		std::uint64_t session;
+		std::wstring label;
+		SigMan::NetStat stat = SigMan::NetStat::ProgramStarted;
+		irr::core::recti rect{}; // Set by layout()
+	};
+	std::vector<Tile> tiles; // By session id, which only grows
+	irr::core::recti area;
+	bool changed = true;
+	// Two triangles per tile, the indices never change.
+	std::array<irr::video::S3DVertex, 4 * maxTiles> vertices;
+	std::array<irr::u16, 6 * maxTiles> indices;
+	std::wstring header;
+	bool labels = false; // Tiles are large enough for their label
+	sf::Music music;
+	bool musicLoaded = false;
+public:
+	explicit SessionDashboard(SigMan & sigMan) {
+		this->attach(sigMan);
+		constexpr std::array<std::size_t, 6> quad{0, 1, 2, 0, 2, 3};
+		for (std::size_t i=0; i<indices.size(); ++i)
+			indices[i] = static_cast<irr::u16>(4 * (i / 6) + quad[i % 6]);
+	}
+	~SessionDashboard() {
+		this->detach();
+		music.stop();
+		if (this->dropped() != 0)
+			std::cout << "Dashboard: " << this->dropped() << " status messages dropped" << std::endl;
+	}
+	void setArea(const irr::core::recti & _area_) {
+		area = _area_;
+		changed = true;
+	}
+	void addSession(std::uint64_t session, const std::string & label) {
+		if (tiles.size() >= maxTiles)
+			this->dropOldest();
+		tiles.push_back({session, std::wstring(label.begin(), label.end())});
+		changed = true;
+		if (!musicLoaded) {
+			const auto data = AssetCache::instance().bytes("audio/session.ogg");
+			musicLoaded = !data.empty() && music.openFromMemory(data.data(), data.size());
+		}
+		if (musicLoaded && music.getStatus() != sf::Music::Playing)
+			music.play();
+	}
+	// Applies the events that arrived since the last call, true when the
+	// grid looks different now.
+	bool refresh() {
+		this->pump();
+		if (!std::exchange(changed, false))
+			return false;
+		this->layout();
+		return true;
+	}
+	void draw(irr::video::IVideoDriver * driver, irr::gui::IGUIFont * font) const {
+		if (font)
+			font->draw(
+				header.data(),
+				irr::core::recti{area.UpperLeftCorner, irr::core::position2di{area.LowerRightCorner.X, area.UpperLeftCorner.Y + headerHeight}},
+				irr::video::SColor{0xff584552}
+			);
+		if (tiles.empty())
+			return;
+		if (drawsVertexLists(driver))
+			driver->draw2DVertexPrimitiveList(
+				vertices.data(),
+				static_cast<irr::u32>(4 * tiles.size()),
+				indices.data(),
+				static_cast<irr::u32>(2 * tiles.size()),
+				irr::video::EVT_STANDARD,
+				irr::scene::EPT_TRIANGLES,
+				irr::video::EIT_16BIT
+			);
+		else
+			for (const Tile & tile: tiles)
+				driver->draw2DRectangle(irr::video::SColor{std::to_underlying(SessionDashboard::color(tile.stat))}, tile.rect);
+		if (!font || !labels)
+			return;
+		for (const Tile & tile: tiles)
+			font->draw(
+				tile.label.data(),
+				tile.rect,
+				irr::video::SColor{tile.stat == SigMan::NetStat::Got ? 0xff141414 : 0xffffffff},
+				true,
+				true,
+				&tile.rect
+			);
+	}
+private:
+	void update(const SigMan::Event & event) override {
+		auto iter = std::lower_bound(
+			tiles.begin(),
+			tiles.end(),
+			event.session,
+			[] (const Tile & tile, std::uint64_t session) { return tile.session < session; }
+		);
+		if (iter == tiles.end() || iter->session != event.session || iter->stat == event.stat)
+			return;
+		iter->stat = event.stat;
+		changed = true;
+	}
+	// Places the tiles in the grid under the header and turns them into
+	// quads. The grid always holds all tiles, so every one is visible.
+	void layout() {
+		std::size_t running = 0;
+		std::size_t failed = 0;
+		for (const Tile & tile: tiles) {
+			if (SessionDashboard::failed(tile.stat))
+				++failed;
+			else if (tile.stat != SigMan::NetStat::Got)
+				++running;
+		}
+		header = L"Sessions: " + std::to_wstring(tiles.size())
+			+ L"   running: " + std::to_wstring(running)
+			+ L"   done: " + std::to_wstring(tiles.size() - running - failed)
+			+ L"   failed: " + std::to_wstring(failed);
+		labels = false;
+		if (tiles.empty())
+			return;
+		const irr::core::recti grid{
+			area.UpperLeftCorner.X,
+			area.UpperLeftCorner.Y + headerHeight,
+			area.LowerRightCorner.X,
+			area.LowerRightCorner.Y
+		};
+		const irr::s32 width = grid.getWidth();
+		const irr::s32 height = grid.getHeight();
+		// Enough columns for tiles about four times as wide as high.
+		const irr::s32 count = static_cast<irr::s32>(tiles.size());
+		const irr::s32 columns = std::clamp(
+			static_cast<irr::s32>(std::ceil(std::sqrt(count * width / (4.0 * height)))),
+			1,
+			count
+		);
+		const irr::s32 rows = (count + columns - 1) / columns;
+		const irr::s32 tileWidth = std::min(width / columns, 240);
+		const irr::s32 tileHeight = std::min(height / rows, 60);
+		const irr::s32 gap = tileWidth > 8 && tileHeight > 8 ? 2 : 0;
+		labels = tileWidth >= 100 && tileHeight >= 18;
+		for (irr::s32 i=0; i<count; ++i) {
+			Tile & tile = tiles[i];
+			const irr::s32 x = grid.UpperLeftCorner.X + (i % columns) * tileWidth;
+			const irr::s32 y = grid.UpperLeftCorner.Y + (i / columns) * tileHeight;
+			tile.rect = irr::core::recti{x, y, x + tileWidth - gap, y + tileHeight - gap};
+			const irr::video::SColor color{std::to_underlying(SessionDashboard::color(tile.stat))};
+			const auto left = static_cast<float>(tile.rect.UpperLeftCorner.X);
+			const auto top = static_cast<float>(tile.rect.UpperLeftCorner.Y);
+			const auto right = static_cast<float>(tile.rect.LowerRightCorner.X);
+			const auto bottom = static_cast<float>(tile.rect.LowerRightCorner.Y);
+			vertices[4 * i] = irr::video::S3DVertex{left, top, 0, 0, 0, 1, color, 0, 0};
+			vertices[4 * i + 1] = irr::video::S3DVertex{right, top, 0, 0, 0, 1, color, 0, 0};
+			vertices[4 * i + 2] = irr::video::S3DVertex{right, bottom, 0, 0, 0, 1, color, 0, 0};
+			vertices[4 * i + 3] = irr::video::S3DVertex{left, bottom, 0, 0, 0, 1, color, 0, 0};
+		}
+	}
+	void dropOldest() {
+		auto iter = std::find_if(tiles.begin(), tiles.end(), [] (const Tile & tile) {
+			return tile.stat == SigMan::NetStat::Got || SessionDashboard::failed(tile.stat);
+		});
+		tiles.erase(iter == tiles.end() ? tiles.begin() : iter);
+	}
+	static bool failed(SigMan::NetStat stat) {
+		return stat == SigMan::NetStat::NetworkException || stat == SigMan::NetStat::CppGeneralException;
+	}
+	static Color color(SigMan::NetStat stat) {
+		switch (stat) {
+		case SigMan::NetStat::Resolved:
+			return Color::LightBlue;
+		case SigMan::NetStat::Connected:
+			return Color::DarkBlue;
+		case SigMan::NetStat::Handshaked:
+			return Color::NGreen;
+		case SigMan::NetStat::Requested:
+			return Color::NYellow;
+		case SigMan::NetStat::Got:
+			return Color::NLight;
+		case SigMan::NetStat::NetworkException:
+			return Color::Red1;
+		case SigMan::NetStat::CppGeneralException:
+			return Color::Red2;
+		default:
+			return Color::Grey;
+		}
+	}
+};
+
+// "1.2" for TLS v1.2 and so on, "-" when the version is not known.
+std::string tlsVersionString(std::uint16_t code) {
+	if (code == 0)
+		return "-";
+	if (code > 0x0300 && code <= 0x03ff)
+		return "1." + std::to_string((code & 0xff) - 1);
+	return std::to_string(code);
+}
+
+struct ProbeTarget {
+	std::string host;
+	std::string port;
+};
+
+// Parses "host", "host:port", "[v6addr]" and "[v6addr]:port", the same way
+// for the Host box, --target and --batch lines. An IPv6 address must be in
+// brackets: "::1" or "fe80::1:443" could be read more than one way, so any
+// other entry with more than one ':' is refused, as is an empty host or port.
+ProbeTarget parseTarget(std::string_view entry, std::string_view defaultPort) {
+	auto bad = [entry] (const char * why) {
+		return std::runtime_error{"Bad target \""s + std::string{entry} + "\": " + why};
+	};
+	ProbeTarget target;
+	std::string_view rest;
+	if (entry.starts_with('[')) {
+		const auto close = entry.find(']');
+		if (close == std::string_view::npos)
+			throw bad("no closing ']'");
+		target.host = entry.substr(1, close - 1);
+		rest = entry.substr(close + 1);
+		if (!rest.empty() && rest.front() != ':')
+			throw bad("expected ':' after ']'");
+	} else {
+		const auto colon = entry.find(':');
+		if (colon != std::string_view::npos && entry.find(':', colon + 1) != std::string_view::npos)
+			throw bad("write an IPv6 address as [addr]:port");
+		target.host = entry.substr(0, colon);
+		if (colon != std::string_view::npos)
+			rest = entry.substr(colon);
+	}
+	if (target.host.empty())
+		throw bad("no host");
+	if (rest.empty())
+		target.port = defaultPort;
+	else if (rest.size() == 1)
+		throw bad("no port after ':'");
+	else
+		target.port = rest.substr(1);
+	return target;
+}
+
+struct ProbeResult;
+struct ProbeOptions;
+
+// Finished sessions kept column by column: one vector per field and all
+// host:port labels back to back in one string, so 100k rows take a few
+// megabytes and a row only becomes text while it is on screen. Sessions
+// finish on the io threads and leave their rows in the Inbox, collect()
+// moves them into the columns on the window thread, the only one that
+// reads them.
+class ResultStore {
+public:
+	enum Phase {
+		Dns,
+		Connect,
+		Tls,
+		Ttfb,
+		Body,
+		Total,
+		phaseCount
+	};
+	struct Row {
+		std::string label;
+		SigMan::NetStat stat = SigMan::NetStat::ProgramStarted; // Last phase reached
+		bool failed = false;
+		std::array<float, phaseCount> ms; // NaN where the phase did not run
+		std::uint16_t tlsVersion = 0;
+		std::uint16_t httpStatus = 0;
+		static Row of(const ProbeResult & result);
+	};
+	// Unbounded multi-producer single-consumer list. add() links a row in
+	// with one compare-exchange, takeAll() detaches the whole list with one
+	// exchange, so neither the io threads nor the window thread ever wait
+	// and no row is dropped. Nodes are never popped one by one, so there is
+	// no ABA problem.
+	class Inbox {
+	private:
+		struct Node {
+			Row row;
+			Node * next;
+		};
+		std::atomic<Node *> head = nullptr;
+	public:
+		Inbox() = default;
+		Inbox(const Inbox &) = delete;
+		Inbox & operator=(const Inbox &) = delete;
+		~Inbox() {
+			std::vector<Row> rest;
+			this->takeAll(rest);
+		}
+		void add(Row && row) {
+			Node * node = new Node{std::move(row), head.load(std::memory_order_relaxed)};
+			while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+				;
+		}
+		// Consumer side, one thread at a time. Appends in arrival order.
+		void takeAll(std::vector<Row> & into) {
+			Node * node = head.exchange(nullptr, std::memory_order_acquire);
+			Node * oldest = nullptr; // The list is newest first, turn it around
+			while (node != nullptr) {
+				Node * next = node->next;
+				node->next = oldest;
+				oldest = node;
+				node = next;
+			}
+			while (oldest != nullptr) {
+				into.push_back(std::move(oldest->row));
+				Node * next = oldest->next;
+				delete oldest;
+				oldest = next;
+			}
+		}
+	};
+private:
+	static constexpr std::uint8_t failedBit = 0x80;
+	// Sessions hold on to it, so one that finishes after the window is gone
+	// still has somewhere to leave its row.
+	std::shared_ptr<Inbox> inbox = std::make_shared<Inbox>();
+	std::vector<Row> arrived; // Filled from the inbox, keeps its capacity
+	std::string labels;
+	std::vector<std::uint32_t> labelEnds;
+	std::vector<std::uint8_t> stats; // NetStat, failedBit when the session failed
+	std::array<std::vector<float>, phaseCount> phases;
+	std::vector<std::uint16_t> tlsVersions;
+	std::vector<std::uint16_t> httpStatuses;
+public:
+	std::shared_ptr<Inbox> sink() const {
+		return inbox;
+	}
+	// Appends the rows that arrived since the last call, returns how many.
+	std::size_t collect() {
+		inbox->takeAll(arrived);
+		for (Row & row: arrived) {
+			labels += row.label;
+			labelEnds.push_back(static_cast<std::uint32_t>(labels.size()));
+			stats.push_back(std::to_underlying(row.stat) | (row.failed ? failedBit : 0));
+			for (int phase=0; phase<phaseCount; ++phase)
+				phases[phase].push_back(row.ms[phase]);
+			tlsVersions.push_back(row.tlsVersion);
+			httpStatuses.push_back(row.httpStatus);
+		}
+		const std::size_t count = arrived.size();
+		arrived.clear();
+		return count;
+	}
+	std::size_t size() const {
+		return labelEnds.size();
+	}
+	std::string_view label(std::size_t row) const {
+		const std::size_t begin = row == 0 ? 0 : labelEnds[row - 1];
+		return std::string_view{labels}.substr(begin, labelEnds[row] - begin);
+	}
+	SigMan::NetStat stat(std::size_t row) const {
+		return static_cast<SigMan::NetStat>(stats[row] & ~failedBit);
+	}
+	bool failed(std::size_t row) const {
+		return stats[row] & failedBit;
+	}
+	float ms(std::size_t row, Phase phase) const {
+		return phases[phase][row];
+	}
+	std::uint16_t tlsVersion(std::size_t row) const {
+		return tlsVersions[row];
+	}
+	std::uint16_t httpStatus(std::size_t row) const {
+		return httpStatuses[row];
+	}
+};
+
+// The results table under the dashboard. Whatever the number of rows, it is
+// one scroll bar plus the rows that fit: each frame formats and draws only
+// those, straight from the ResultStore, so no GUI element is ever made per
+// result. While the last row is in view the table follows new results.
+class ResultTable {
+private:
+	struct Column {
+		const wchar_t * title;
+		irr::s32 chars; // Width in characters, 0 takes the rest
+	};
+	static constexpr std::array<Column, 10> columns{{
+		{L"Host", 0},
+		{L"Status", 13},
+		{L"DNS", 7},
+		{L"Connect", 7},
+		{L"TLS", 7},
+		{L"TTFB", 7},
+		{L"Body", 7},
+		{L"Total", 8},
+		{L"Ver", 3},
+		{L"HTTP", 4}
+	}};
+	ResultStore store;
+	irr::core::recti area;
+	irr::gui::IGUIScrollBar * scrollBar = nullptr;
+	irr::s32 rowHeight = 18;
+	irr::s32 charWidth = 9;
+	std::size_t first = 0; // Top visible row
+	bool follow = true;
+public:
+	std::shared_ptr<ResultStore::Inbox> sink() const {
+		return store.sink();
+	}
+	// Lays the table out in _area_ and adds its scroll bar, the one GUI
+	// element it has.
+	void place(irr::gui::IGUIEnvironment * igui, const irr::core::recti & _area_, irr::s32 scrollBarId) {
+		area = _area_;
+		if (irr::gui::IGUIFont * font = igui->getSkin()->getFont()) {
+			const auto size = font->getDimension(L"0");
+			charWidth = static_cast<irr::s32>(size.Width);
+			rowHeight = static_cast<irr::s32>(size.Height) + 4;
+		}
+		constexpr irr::s32 scrollBarWidth = 16;
+		scrollBar = igui->addScrollBar(
+			false, // horizontal
+			irr::core::recti{
+				area.LowerRightCorner.X - scrollBarWidth,
+				area.UpperLeftCorner.Y + 2 * rowHeight,
+				area.LowerRightCorner.X,
+				area.LowerRightCorner.Y
+			},
+			nullptr,
+			scrollBarId
+		);
+		area.LowerRightCorner.X -= scrollBarWidth + 4;
+		this->syncScrollBar();
+	}
+	// Takes in the finished sessions, true when there were any.
+	bool refresh() {
+		if (store.collect() == 0)
+			return false;
+		if (follow)
+			first = this->maxFirst();
+		this->syncScrollBar();
+		return true;
+	}
+	void scrollTo(irr::s32 position) {
+		first = std::min<std::size_t>(std::max(position, 0), this->maxFirst());
+		follow = first == this->maxFirst();
+	}
+	// Mouse wheel over the table, true when it scrolled.
+	bool wheel(const irr::core::position2di & cursor, float delta) {
+		if (!area.isPointInside(cursor) || store.size() == 0)
+			return false;
+		this->scrollTo(static_cast<irr::s32>(first) - static_cast<irr::s32>(delta * 3));
+		this->syncScrollBar();
+		return true;
+	}
+	void draw(irr::video::IVideoDriver * driver, irr::gui::IGUIFont * font) const {
+		if (!font)
+			return;
+		const irr::video::SColor text{0xff141414};
+		irr::s32 y = area.UpperLeftCorner.Y;
+		font->draw(
+			(L"Results: " + std::to_wstring(store.size()) + L" sessions, times in ms").data(),
+			this->line(y),
+			irr::video::SColor{0xff584552}
+		);
+		y += rowHeight;
+		driver->draw2DRectangle(irr::video::SColor{std::to_underlying(Color::NCyan)}, this->line(y), &area);
+		this->drawCells(font, y, irr::video::SColor{0xffffffff}, [] (std::size_t column, std::span<wchar_t> cell) {
+			std::wcsncpy(cell.data(), columns[column].title, cell.size());
+		});
+		y += rowHeight;
+		const std::size_t last = std::min(store.size(), first + this->visibleRows());
+		for (std::size_t row=first; row<last; ++row, y+=rowHeight) {
+			if (row % 2 == 1)
+				driver->draw2DRectangle(irr::video::SColor{0xffdde2e6}, this->line(y), &area);
+			this->drawCells(
+				font,
+				y,
+				store.failed(row) ? irr::video::SColor{std::to_underlying(Color::Red2)} : text,
+				[this, row] (std::size_t column, std::span<wchar_t> cell) {
+					this->format(row, column, cell);
+				}
+			);
+		}
+	}
+private:
+	irr::core::recti line(irr::s32 y) const {
+		return {area.UpperLeftCorner.X, y, area.LowerRightCorner.X, y + rowHeight};
+	}
+	template <typename Formatter>
+	void drawCells(irr::gui::IGUIFont * font, irr::s32 y, irr::video::SColor color, Formatter && formatter) const {
+		irr::s32 fixed = 0;
+		for (const Column & column: columns)
+			fixed += (column.chars + 1) * charWidth;
+		irr::s32 x = area.UpperLeftCorner.X + 4;
+		std::array<wchar_t, 128> cell;
+		for (std::size_t i=0; i<columns.size(); ++i) {
+			const irr::s32 width = columns[i].chars == 0
+				? std::max(area.getWidth() - 8 - fixed, 4 * charWidth)
+				: (columns[i].chars + 1) * charWidth;
+			cell.fill(L'\0');
+			formatter(i, std::span<wchar_t>{cell.data(), cell.size() - 1});
+			const irr::core::recti rect{x, y, std::min(x + width - charWidth / 2, area.LowerRightCorner.X), y + rowHeight};
+			font->draw(cell.data(), rect, color, false, true, &rect);
+			x += width;
+		}
+	}
+	// Writes one cell of a row into cell, which is zero filled.
+	void format(std::size_t row, std::size_t column, std::span<wchar_t> cell) const {
+		switch (column) {
+		case 0: {
+			const auto label = store.label(row);
+			std::copy_n(label.begin(), std::min(label.size(), cell.size()), cell.begin());
+			break;
+		}
+		case 1:
+			std::wcsncpy(cell.data(), ResultTable::status(store.stat(row), store.failed(row)), cell.size());
+			break;
+		case 8: {
+			const std::string version = tlsVersionString(store.tlsVersion(row));
+			std::copy_n(version.begin(), std::min(version.size(), cell.size()), cell.begin());
+			break;
+		}
+		case 9:
+			if (store.httpStatus(row) != 0)
+				std::swprintf(cell.data(), cell.size(), L"%u", unsigned{store.httpStatus(row)});
+			else
+				cell[0] = L'-';
+			break;
+		default: {
+			const float ms = store.ms(row, static_cast<ResultStore::Phase>(column - 2));
+			if (std::isnan(ms))
+				cell[0] = L'-';
+			else
+				std::swprintf(cell.data(), cell.size(), L"%.1f", ms);
+			break;
+		}
+		}
+	}
+	// A failed session names the phase that failed, the one after the
+	// last it reached.
+	static const wchar_t * status(SigMan::NetStat stat, bool failed) {
+		switch (stat) {
+		case SigMan::NetStat::ProgramStarted:
+			return failed ? L"FAIL dns" : L"started";
+		case SigMan::NetStat::Resolved:
+			return failed ? L"FAIL connect" : L"resolved";
+		case SigMan::NetStat::Connected:
+			return failed ? L"FAIL tls" : L"connected";
+		case SigMan::NetStat::Handshaked:
+			return failed ? L"FAIL request" : L"handshaked";
+		case SigMan::NetStat::Requested:
+			return failed ? L"FAIL response" : L"requested";
+		case SigMan::NetStat::Got:
+			return failed ? L"FAIL response" : L"OK";
+		default:
+			return L"FAIL error";
+		}
+	}
+	std::size_t visibleRows() const {
+		return static_cast<std::size_t>(std::max(area.getHeight() / rowHeight - 2, 0));
+	}
+	std::size_t maxFirst() const {
+		return store.size() - std::min(store.size(), this->visibleRows());
+	}
+	void syncScrollBar() {
+		if (!scrollBar)
+			return;
+		scrollBar->setMax(static_cast<irr::s32>(this->maxFirst()));
+		scrollBar->setLargeStep(static_cast<irr::s32>(std::max<std::size_t>(this->visibleRows(), 1)));
+		scrollBar->setPos(static_cast<irr::s32>(first));
+	}
+};
+
+// The phase latencies of the latest finished sessions, for LatencyChart. Any
+// io thread adds a sample and the window thread reads them, neither takes a
+// lock: each slot carries a sequence number that is odd while a writer is
+// in it, and a reader that sees it change keeps its old copy of the sample.
+// Once full, every sample replaces the oldest one.
+class LatencyRing {
+public:
+	static constexpr std::size_t capacity = 256;
+	enum Series {
+		Dns,
+		Connect,
+		Tls,
+		Ttfb,
+		seriesCount
+	};
+	using Sample = std::array<float, seriesCount>; // ms, NaN where the phase did not run
+private:
+	struct Slot {
+		std::atomic<std::uint64_t> sequence = 0;
+		std::array<std::atomic<float>, seriesCount> ms{};
+	};
+	std::array<Slot, capacity> slots;
+	alignas(64) std::atomic<std::uint64_t> written = 0;
+public:
+	void push(const Sample & sample) noexcept {
+		const std::uint64_t n = written.fetch_add(1, std::memory_order_relaxed);
+		Slot & slot = slots[n % capacity];
+		slot.sequence.store(2 * n + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (std::size_t i=0; i<seriesCount; ++i)
+			slot.ms[i].store(sample[i], std::memory_order_relaxed);
+		slot.sequence.store(2 * n + 2, std::memory_order_release);
+	}
+	// Number of samples ever pushed, the last capacity of them are kept.
+	std::uint64_t count() const noexcept {
+		return written.load(std::memory_order_acquire);
+	}
+	// Copies sample n, false when it is being written or already replaced.
+	bool read(std::uint64_t n, Sample & sample) const noexcept {
+		const Slot & slot = slots[n % capacity];
+		if (slot.sequence.load(std::memory_order_acquire) != 2 * n + 2)
+			return false;
+		for (std::size_t i=0; i<seriesCount; ++i)
+			sample[i] = slot.ms[i].load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == 2 * n + 2;
+	}
+};
+
+// Rolling chart of the resolve, connect, handshake and TTFB times of the
+// last LatencyRing::capacity sessions, newest on the right. refresh() copies
+// the ring into fixed arrays and turns it into line vertices, draw() hands
+// all four series to the driver in one draw2DVertexPrimitiveList call, or
+// line by line on the software drivers. The window thread never waits on
+// the io threads and nothing here allocates once the captions have grown
+// to their longest.
+class LatencyChart {
+private:
+	static constexpr std::size_t capacity = LatencyRing::capacity;
+	static constexpr std::size_t seriesCount = LatencyRing::seriesCount;
+	static constexpr std::array<const wchar_t *, seriesCount> names{L"dns", L"connect", L"tls", L"ttfb"};
+	static constexpr std::array<Color, seriesCount> colors{Color::LightBlue, Color::DarkBlue, Color::NGreen, Color::Red1};
+	std::shared_ptr<LatencyRing> ring = std::make_shared<LatencyRing>();
+	std::uint64_t seen = 0;
+	std::array<LatencyRing::Sample, capacity> samples;
+	std::size_t sampleCount = 0;
+	std::array<irr::video::S3DVertex, capacity * seriesCount> vertices;
+	std::array<irr::u16, 2 * (capacity - 1) * seriesCount> indices;
+	irr::u32 lineCount = 0;
+	std::array<irr::core::stringw, seriesCount + 1> captions; // One per series, then the scale
+	irr::core::recti area;
+	irr::core::recti plot;
+public:
+	std::shared_ptr<LatencyRing> sink() const {
+		return ring;
+	}
+	void setArea(const irr::core::recti & _area_) {
+		area = _area_;
+		plot = irr::core::recti{area.UpperLeftCorner.X + 4, area.UpperLeftCorner.Y + 22, area.LowerRightCorner.X - 4, area.LowerRightCorner.Y - 4};
+		seen = 0;
+	}
+	// Takes the samples pushed since the last call, true when there were any.
+	bool refresh() {
+		const std::uint64_t count = ring->count();
+		if (count == seen)
+			return false;
+		// A sample counted but still being written can not be read yet;
+		// seen stays before it, so the next call tries it again.
+		const std::uint64_t begin = count > capacity ? count - capacity : 0;
+		std::size_t readCount = 0;
+		std::uint64_t lastRead = 0;
+		for (std::uint64_t n=begin; n<count; ++n)
+			if (ring->read(n, samples[readCount])) {
+				++readCount;
+				lastRead = n;
+			}
+		if (readCount == 0)
+			return false;
+		seen = lastRead + 1;
+		sampleCount = readCount;
+		this->layout();
+		return true;
+	}
+	void draw(irr::video::IVideoDriver * driver, irr::gui::IGUIFont * font) const {
+		driver->draw2DRectangle(irr::video::SColor{0xffe6eaed}, area);
+		driver->draw2DRectangleOutline(plot, irr::video::SColor{0xff9aa3ab});
+		if (lineCount != 0 && drawsVertexLists(driver)) {
+			driver->draw2DVertexPrimitiveList(
+				vertices.data(),
+				static_cast<irr::u32>(sampleCount * seriesCount),
+				indices.data(),
+				lineCount,
+				irr::video::EVT_STANDARD,
+				irr::scene::EPT_LINES,
+				irr::video::EIT_16BIT
+			);
+		} else {
+			auto point = [] (const irr::video::S3DVertex & vertex) {
+				return irr::core::position2di{static_cast<irr::s32>(vertex.Pos.X), static_cast<irr::s32>(vertex.Pos.Y)};
+			};
+			for (irr::u32 i=0; i<lineCount; ++i) {
+				const irr::video::S3DVertex & from = vertices[indices[2 * i]];
+				driver->draw2DLine(point(from), point(vertices[indices[2 * i + 1]]), from.Color);
+			}
+		}
+		if (!font || sampleCount == 0)
+			return;
+		irr::s32 x = area.UpperLeftCorner.X + 4;
+		const irr::s32 y = area.UpperLeftCorner.Y + 2;
+		const irr::s32 width = area.getWidth() / (seriesCount + 1);
+		for (std::size_t i=0; i<=seriesCount; ++i, x+=width) {
+			const irr::core::recti rect{x, y, x + width, y + 18};
+			font->draw(
+				captions[i],
+				rect,
+				irr::video::SColor{std::to_underlying(i < seriesCount ? colors[i] : Color::Grey)},
+				false,
+				true,
+				&rect
+			);
+		}
+	}
+private:
+	// Scales the samples to the plot, newest at the right edge, and links
+	// each one to the one before it where both have the phase.
+	void layout() {
+		float top = 1;
+		for (std::size_t k=0; k<sampleCount; ++k)
+			for (float ms: samples[k])
+				if (!std::isnan(ms))
+					top = std::max(top, ms);
+		top = LatencyChart::niceCeil(top);
+		const float step = static_cast<float>(plot.getWidth()) / (capacity - 1);
+		const float right = static_cast<float>(plot.LowerRightCorner.X);
+		const float bottom = static_cast<float>(plot.LowerRightCorner.Y);
+		const float scale = plot.getHeight() / top;
+		lineCount = 0;
+		for (std::size_t s=0; s<seriesCount; ++s) {
+			const irr::video::SColor color{std::to_underlying(colors[s])};
+			for (std::size_t k=0; k<sampleCount; ++k) {
+				const float ms = samples[k][s];
+				const float x = right - (sampleCount - 1 - k) * step;
+				const float y = std::isnan(ms) ? bottom : bottom - ms * scale;
+				vertices[s * sampleCount + k] = irr::video::S3DVertex{x, y, 0, 0, 0, 1, color, 0, 0};
+				if (k != 0 && !std::isnan(ms) && !std::isnan(samples[k - 1][s])) {
+					indices[2 * lineCount] = static_cast<irr::u16>(s * sampleCount + k - 1);
+					indices[2 * lineCount + 1] = static_cast<irr::u16>(s * sampleCount + k);
+					++lineCount;
+				}
+			}
+		}
+		std::array<wchar_t, 48> text;
+		const LatencyRing::Sample & last = samples[sampleCount - 1];
+		for (std::size_t s=0; s<seriesCount; ++s) {
+			if (std::isnan(last[s]))
+				std::swprintf(text.data(), text.size(), L"%ls -", names[s]);
+			else
+				std::swprintf(text.data(), text.size(), L"%ls %.1f", names[s], last[s]);
+			captions[s] = text.data();
+		}
+		std::swprintf(text.data(), text.size(), L"0-%g ms", top);
+		captions[seriesCount] = text.data();
+	}
+	// The smallest 1, 2 or 5 times a power of ten that is at least value.
+	static float niceCeil(float value) {
+		const float power = std::pow(10.0f, std::floor(std::log10(value)));
+		for (float factor: {1.0f, 2.0f, 5.0f, 10.0f})
+			if (factor * power >= value)
+				return factor * power;
+		return value;
+	}
+};
+
+template <typename IrrlichtWindow>
+class Event: public irr::IEventReceiver {
+private:
+	IrrlichtWindow & window;
+private:
+	irr::IrrlichtDevice * device;
+	irr::video::IVideoDriver * driver;
+	irr::scene::ISceneManager * smgr;
+	irr::gui::IGUIEnvironment * igui;
+	bool attached = false;
+
+	sf::Sound sound;
+	std::shared_ptr<const sf::SoundBuffer> click;
+public:
+	Event(
+		IrrlichtWindow & window
+	) noexcept
+	:
+		window{window},
+		device{nullptr}
+	{
+		click = AssetCache::instance().sound("audio/click.ogg");
+		if (click)
+			sound.setBuffer(*click);
+	}
+	void attachDevice() {
+		if (!window.opened)
+			throw std::runtime_error{"Attach Event to Window Error: because window is not opened!"};
+		device = window.device;
+		device->setEventReceiver(this);
+		attached = true;
+		driver = device->getVideoDriver();
+		smgr = device->getSceneManager();
+		igui = device->getGUIEnvironment();
+	}
+	void playClick() {
+		if (click)
+			sound.play();
+	}
+	bool OnEvent(const irr::SEvent & event) override {
+		window.pacer.markDirty();
+		switch (event.EventType) {
+		case irr::EET_KEY_INPUT_EVENT:
+			this->processKey(event);
+			break;
+		case irr::EET_GUI_EVENT:
+			this->processGUIEvent(event);
+			break;
+		case irr::EET_MOUSE_INPUT_EVENT:
+			if (event.MouseInput.Event == irr::EMIE_MOUSE_WHEEL)
+				return window.results.wheel({event.MouseInput.X, event.MouseInput.Y}, event.MouseInput.Wheel);
+			break;
+		default:
+			break;
+		}
+		return false;
+	}
+	inline void processKey(const irr::SEvent & event) {
+		if (event.KeyInput.PressedDown)
+			return;
+		switch (event.KeyInput.Key) {
+		case irr::KEY_KEY_Q:
+			window.opened = false;
+			this->attached = false;
+			device->closeDevice();
+			std::cout << "MainWindow is closed!" << std::endl;
+			break;
+		default:
+			break;
+		}
+	}
+	inline void processGUIEvent(const irr::SEvent & event) {
+		switch (event.GUIEvent.EventType) {
+		case irr::gui::EGET_MENU_ITEM_SELECTED:
+			this->playClick();
+			this->processMenuItemSelected(event);
+			break;
+		case irr::gui::EGET_BUTTON_CLICKED:
+			this->playClick();
+			this->processButtonClicked(event);
+			break;
+		case irr::gui::EGET_SCROLL_BAR_CHANGED:
+			if (event.GUIEvent.Caller->getID() == scrollid_results)
+				window.results.scrollTo(static_cast<irr::gui::IGUIScrollBar *>(event.GUIEvent.Caller)->getPos());
+			break;
 		default:
 			break;
 		}
@@ -272,7 +2107,7 @@ public:
 		case menuid_about:
 			igui->addMessageBox(
 				L"About",
-				L"Micburs - A cpp (c++) pogram to get Https(TLS) host resolve status. Window ui is written in irrlicht.\n\nLibraries:\n\t\t\t\tboost::asio\n\t\t\t\tboost::beast\n\t\t\t\tboost::signals2\n\t\t\t\tBotan::TLS\n\t\t\t\tSFML Audio\n\t\t\t\tIrrlicht Engine\n\t\t\t\t",
+				L"Micburs - A cpp (c++) pogram to get Https(TLS) host resolve status. Window ui is written in irrlicht.\n\nLibraries:\n\t\t\t\tboost::asio\n\t\t\t\tboost::beast\n\t\t\t\tBotan::TLS\n\t\t\t\tSFML Audio\n\t\t\t\tIrrlicht Engine\n\t\t\t\t",
 				true, // Modal
 				irr::gui::EMBF_OK,
 				nullptr, // parent
@@ -310,63 +2145,64 @@ public:
 			break;
 		}
 	}
+	// The Host box takes several hosts separated by spaces or commas, each
+	// one becomes a session and a tile of the dashboard. "host:port" and
+	// "[v6addr]:port" override the Port box, see parseTarget().
 	void startNewSession() {
-		bool isGood = true;
-		std::wstring host;
-		std::wstring port;
-		const std::wstring title = L"Error Message Box:";
-		std::wstring text;
-		if (sessionRunning) {
-			isGood = false;
-			text = L"Please close the old session window! Old Session is Running!";
-		} else {
-			hostBox = window.hostBox;
-			portBox = window.portBox;
-			std::cout << "hotBox and portBox set!" << std::endl;
-			host = hostBox->getText();
-			port = portBox->getText();
-			if (host == L"") {
-				isGood = false;
-				text = L"\"Host:\" area should not be empty!";
-			} else if (port == L"") {
-				port = L"443";
+		std::wstring hosts = window.hostBox->getText();
+		std::wstring port = window.portBox->getText();
+		if (port == L"")
+			port = L"443";
+		std::replace(hosts.begin(), hosts.end(), L',', L' ');
+		std::wistringstream entries{hosts};
+		std::wstring entry;
+		bool entered = false;
+		while (entries >> entry) {
+			entered = true;
+			std::string entry_string;
+			std::string port_string;
+			std::copy(entry.begin(), entry.end(), std::back_inserter(entry_string));
+			std::copy(port.begin(), port.end(), std::back_inserter(port_string));
+			ProbeTarget target;
+			try {
+				target = parseTarget(entry_string, port_string);
+			} catch (std::exception & exc) {
+				const std::string what = exc.what();
+				igui->addMessageBox(
+					L"Error Message Box:",
+					std::wstring{what.begin(), what.end()}.c_str(),
+					true,
+					irr::gui::EMBF_OK,
+					nullptr,
+					-1,
+					nullptr
+				);
+				continue;
 			}
+			std::cout << "Input (host, port) => " 
+				<< "(" << target.host << ", " 
+				<< target.port << ")"
+				<< std::endl;
+			window.newSession(target.host, target.port);
 		}
-
-		if (!isGood) {
+		if (!entered)
 			igui->addMessageBox(
-				title.data(),
-				text.data(),
+				L"Error Message Box:",
+				L"\"Host:\" area should not be empty!",
 				true,
 				irr::gui::EMBF_OK,
 				nullptr,
 				-1,
 				nullptr
 			);
-			return;
-		}
-		std::string host_string;
-		std::string port_string;
-		std::copy(host.begin(), host.end(), std::back_inserter(host_string));
-		std::copy(port.begin(), port.end(), std::back_inserter(port_string));
-		std::cout << "Input (host, port) => " 
-			<< "(" << host_string << ", " 
-			<< port_string << ")"
-			<< std::endl;
-		sessionRunning = true;
-		sessionThread = std::async(
-			std::launch::async,
-			&IrrlichtWindow::newSession,
-			&window,
-			host_string,
-			port_string
-		);
 	}
 };
 
 class MainWindow {
 private:	
 	SigMan & sigMan;
+	IoContextPool & ioPool;
+	std::shared_ptr<const ProbeOptions> probeOptions; // From the command line
 	irr::u32 width;
 	irr::u32 height;
 	irr::video::E_DRIVER_TYPE driverType;
@@ -379,25 +2215,39 @@ private:
 
 	friend class Event<MainWindow>;
 	class Event<MainWindow> event;
+	FramePacer pacer{std::chrono::milliseconds{500}}; // Edit box cursors blink
+	SessionDashboard dashboard;
+	ResultTable results;
+	LatencyChart latencies;
 
 	bool opened;
 
 	irr::gui::IGUIEditBox * hostBox = nullptr;
 	irr::gui::IGUIEditBox * portBox = nullptr;
+
+	// Time to first frame, counted from program start.
+	static inline const auto programStart = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::duration setupTime{}; // Fonts, textures and widgets
+	bool firstFrameShown = false;
 public:
 	MainWindow(
 		irr::u32 width,
 		irr::u32 height,
 		irr::video::E_DRIVER_TYPE driverType,
-		SigMan & sigMan
+		SigMan & sigMan,
+		IoContextPool & ioPool,
+		std::shared_ptr<const ProbeOptions> probeOptions
 	) noexcept
 	:
 		sigMan{sigMan},
+		ioPool{ioPool},
+		probeOptions{std::move(probeOptions)},
 		width{width>1280?width:1280},
 		height{height>720?height:720},
 		driverType{driverType},
 		device{nullptr},
-		event{std::ref(*this), sigMan},
+		event{std::ref(*this)},
+		dashboard{sigMan},
 		opened{false}
 	{
 		std::cout << "MainWindow: " << (this->width) << " x " << this->height
@@ -432,8 +2282,10 @@ private:
 		device->setWindowCaption(L"Micburs NetStat Main Window - Powered by Irrlicht");
 		device->setResizable(false);
 		this->obtainIrrlichtObjects();
+		const auto setupStart = std::chrono::steady_clock::now();
 		this->setupFonts();
 		this->createWidgets();
+		setupTime = std::chrono::steady_clock::now() - setupStart;
 		this->startWindowLoop();
 	}
 	void obtainIrrlichtObjects() {
@@ -443,7 +2295,9 @@ private:
 		fs = device->getFileSystem();
 	}
 	void setupFonts() {
-		fs->addFileArchive("./media");
+		auto * archive = new MediaArchive{fs};
+		fs->addFileArchive(archive);
+		archive->drop();
 		irr::gui::IGUISkin * skin = igui->getSkin();
 		irr::gui::IGUIFont * font = igui->getFont("Liberation-Mono.1ASC.14-bold.xml");
 		if (font == nullptr) {
@@ -615,12 +2469,12 @@ private:
 			L"C++ Irrlicht"
 		);
 	////////////////////////////////////////////////////////////////////////
-		const irr::s32 t_x = 320;
-		const irr::s32 t_y = 320;
-		x = (this->width - t_x)/2;
-		y = (this->height - t_y)/2;
+		const irr::s32 t_x = img_w;
+		const irr::s32 t_y = 290;
+		x = this->width - t_x - 10;
+		y = y - t_y - 10;
 		igui->addStaticText(
-			L"Input the hostname \nand the HTTPS(TLS) Port, \nthen Press \"Start Session\".\n\nHost can not be empty.\n\nPort can be empty.\n\nIf port is empty, the default TLS port number 443 will be used.\n\n(Cpp (c++) Project)\n\n",
+			L"Input the hostname and the HTTPS(TLS) Port, then Press \"Start Session\". Several hosts can be separated by spaces or commas, host:port overrides the Port box.\n\nIf port is empty, the default TLS port number 443 will be used.\n\nGrey: Session Started\nLight Blue: Host Resolved\nDark Blue: Host Connected\nGreen: HTTPS(TLS) Handshaked\nYellow: Reuqest sent\nLight: Https Server Responsed (All Finished!)\nRed 1: Network Exception\nRed 2: Program Exception\n",
 			irr::core::recti{x, y, x + t_x, y + t_y},
 			true, // border
 			true, // world wrap
@@ -628,6 +2482,10 @@ private:
 			-1, // id
 			false // fill background
 		);
+	////////////////////////////////////////////////////////////////////////
+		dashboard.setArea(irr::core::recti{20, y, x - 20, y + 130});
+		results.place(igui, irr::core::recti{20, y + 140, x - 20, (irr::s32)this->height - 60}, scrollid_results);
+		latencies.setArea(irr::core::recti{x, y1, x + t_x, y - 10});
 	////////////////////////////////////////////////////////////////////////
 		x = (this->width - w1)/2;
 		y = this->height - h1 - h1/2;
@@ -652,13 +2510,29 @@ private:
 private:
 	void runLoopInThread() {
 		while (device->run()) {
+			if (dashboard.refresh())
+				pacer.markDirty();
+			if (results.refresh())
+				pacer.markDirty();
+			if (latencies.refresh())
+				pacer.markDirty();
+			if (!pacer.frameDue(!device->isWindowMinimized()))
+				continue;
 			smgr->drawAll();
+			dashboard.draw(driver, igui->getSkin()->getFont());
+			results.draw(driver, igui->getSkin()->getFont());
+			latencies.draw(driver, igui->getSkin()->getFont());
 			igui->drawAll();
 			this->swapBuffersInThread();
 		}
 	}
 	void swapBuffersInThread() {
 		driver->endScene();
+		if (!std::exchange(firstFrameShown, true))
+			std::cout << "Time to first frame: " << std::fixed << std::setprecision(1)
+				<< std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - programStart}.count()
+				<< "ms (fonts, textures and widgets "
+				<< std::chrono::duration<double, std::milli>{setupTime}.count() << "ms)" << std::endl;
 		driver->beginScene(
 			irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH,
 			irr::video::SColor{std::to_underlying(Color::NLight)}
@@ -668,358 +2542,2838 @@ private:
 	void newSession(const std::string & host, const std::string & port);
 };
 
-class OpenWindow: private MessageTarget {
+// A small stub resolver that speaks DNS (RFC 1035) to the configured
+// nameservers directly on the session's io_context, so no lookup ever waits
+// for asio's getaddrinfo thread. A and AAAA are asked in parallel over UDP,
+// truncated answers are asked again over TCP, and unanswered questions are
+// retried on the next nameserver. IP literals and "localhost" are answered
+// locally; /etc/hosts and search domains are not consulted.
+class DnsResolver {
+public:
+	using Results = tcp::resolver::results_type;
+	using Executor = asio::io_context::executor_type;
+	using Handler = std::function<void(beast::error_code, Results, std::chrono::seconds)>;
+	using udp = asio::ip::udp;
 private:
-	irr::IrrlichtDevice * device = nullptr;
-	bool opened = false;
-	irr::scene::ISceneManager * smgr;
-	irr::video::IVideoDriver * driver;
-	irr::gui::IGUIEnvironment * igui;
-	irr::io::IFileSystem * fs;
-	std::future<void> windowThread;
-
-	std::atomic<Color> color = Color::Grey;
-
-	SigMan & circleSigMan;
-
-	bool attached = false;
+	static inline bool enabledFlag = false;
+	static inline std::vector<udp::endpoint> nameservers;
+	static inline int attempts = 2;
+	static inline std::chrono::milliseconds timeout{1500};
+	class Lookup;
+public:
+	static void configure(
+		std::vector<udp::endpoint> servers,
+		int attemptsPerServer,
+		std::chrono::milliseconds attemptTimeout
+	) {
+		if (servers.empty())
+			servers = DnsResolver::systemNameservers();
+		nameservers = std::move(servers);
+		attempts = std::max(1, attemptsPerServer);
+		timeout = attemptTimeout;
+		enabledFlag = true;
+	}
+	static bool enabled() {
+		return enabledFlag;
+	}
+	// Throws std::invalid_argument unless text is a decimal number up to 65535.
+	static unsigned short parsePort(const std::string & text) {
+		if (text.empty() || text.size() > 5 || !std::all_of(text.begin(), text.end(), [] (char c) { return c >= '0' && c <= '9'; }))
+			throw std::invalid_argument{"Bad port: "s + text};
+		const unsigned long port = std::stoul(text);
+		if (port > std::numeric_limits<unsigned short>::max())
+			throw std::invalid_argument{"Bad port: "s + text};
+		return static_cast<unsigned short>(port);
+	}
+	// Accepts "addr", "addr:port" and "[v6addr]:port".
+	static udp::endpoint parseNameserver(const std::string & text) {
+		std::string address = text;
+		unsigned short port = 53;
+		if (!text.empty() && text.front() == '[') {
+			const auto close = text.find(']');
+			if (close == std::string::npos)
+				throw std::runtime_error{"Bad nameserver: "s + text};
+			address = text.substr(1, close - 1);
+			if (close + 1 < text.size() && text[close + 1] == ':')
+				port = DnsResolver::parsePort(text.substr(close + 2));
+		} else if (std::count(text.begin(), text.end(), ':') == 1) {
+			const auto colon = text.find(':');
+			address = text.substr(0, colon);
+			port = DnsResolver::parsePort(text.substr(colon + 1));
+		}
+		return {asio::ip::make_address(address), port};
+	}
+	static std::vector<udp::endpoint> systemNameservers() {
+		std::vector<udp::endpoint> servers;
+		std::ifstream resolvConf{"/etc/resolv.conf"};
+		std::string keyword;
+		std::string value;
+		while (resolvConf >> keyword) {
+			if (keyword == "nameserver" && resolvConf >> value) {
+				beast::error_code ec;
+				auto address = asio::ip::make_address(value, ec);
+				if (!ec)
+					servers.emplace_back(address, 53);
+			}
+			std::getline(resolvConf, value);
+		}
+		if (servers.empty())
+			servers.emplace_back(asio::ip::address_v4::loopback(), 53);
+		return servers;
+	}
+	static void resolve(
+		Executor executor,
+		const std::string & host,
+		const std::string & port,
+		Handler handler
+	);
+};
 
-	sf::Music music;
+class DnsResolver::Lookup: public std::enable_shared_from_this<DnsResolver::Lookup> {
+private:
+	enum : std::uint16_t {
+		typeA = 1,
+		typeCNAME = 5,
+		typeAAAA = 28
+	};
+	enum class Answer {
+		Records, // NOERROR, records (maybe none) were taken
+		NameError, // NXDOMAIN
+		Truncated, // TC bit, ask again over TCP
+		Retry, // SERVFAIL, REFUSED, malformed: try the next nameserver
+		Ignore // Not an answer to any open question
+	};
+	// A question asked again over TCP after a truncated answer.
+	struct Exchange {
+		tcp::socket socket;
+		std::array<uint8_t, 2> length;
+		std::vector<uint8_t> message;
+	};
+	struct Question {
+		std::uint16_t type;
+		std::uint16_t id = 0;
+		bool done = false;
+		bool overTcp = false;
+		int failedAttempt = 0; // The last attempt whose server answered Retry
+		std::vector<uint8_t> query{};
+		std::shared_ptr<Exchange> exchange{};
+	};
+	const std::string host;
+	const std::string port;
+	const unsigned short portNumber;
+	udp::socket socket;
+	asio::steady_timer timer;
+	Handler handler;
+	std::array<Question, 2> questions{Question{typeAAAA}, Question{typeA}};
+	std::array<uint8_t, 512> datagram;
+	udp::endpoint sender;
+	udp::endpoint server;
+	std::vector<tcp::endpoint> found[2];
+	std::uint32_t minTtl = std::numeric_limits<std::uint32_t>::max();
+	int attempt = 0;
+	bool socketV6 = false;
+	bool nameError = false;
+	bool serverFailed = false; // Some nameserver answered Retry
+	bool finished = false;
 public:
-	OpenWindow(SigMan & sigMan)
+	Lookup(
+		Executor executor,
+		const std::string & host,
+		const std::string & port,
+		unsigned short portNumber,
+		Handler handler
+	)
 	:
-		circleSigMan{sigMan}
+		host{host},
+		port{port},
+		portNumber{portNumber},
+		socket{executor},
+		timer{executor},
+		handler{std::move(handler)}
 	{
-		this->attach(sigMan);
-		attached = true;
-		if (music.openFromFile("./media/audio/session.ogg"))
-			music.play();
 	}
-	~OpenWindow() {
-		windowThread.wait();
-		if (attached) {
-			this->detach();
-			attached = false;
+	void start() {
+		if (host.empty() || host.size() > 253)
+			return this->finish(asio::error::host_not_found);
+		thread_local std::mt19937 random{std::random_device{}()};
+		for (auto & question: questions) {
+			question.id = static_cast<std::uint16_t>(random());
+			question.query = this->buildQuery(question);
 		}
-		music.stop();
-		std::cout << "This session is closed!" << std::endl;
-		circleSigMan.update(SigMan::NetStat::PleaseClose);
+		this->sendAttempt();
 	}
-	void update(SigMan::NetStat status) override {
-		switch (status) {
-		case SigMan::NetStat::ProgramStarted:
-			this->openWindow();
-			break;
-		case SigMan::NetStat::Resolved:
-			color = Color::LightBlue;
-			break;
-		case SigMan::NetStat::Connected:
-			color = Color::DarkBlue;
-			break;
-		case SigMan::NetStat::Handshaked:
-			color = Color::NGreen;
-			break;
-		case SigMan::NetStat::Requested:
-			color = Color::NYellow;
-			break;
-		case SigMan::NetStat::Got:
-			color = Color::NLight;
-			break;
-		case SigMan::NetStat::NetworkException:
-			color = Color::Red1;
-			break;
-		case SigMan::NetStat::CppGeneralException:
-			color = Color::Red2;
+private:
+	std::vector<uint8_t> buildQuery(const Question & question) const {
+		std::vector<uint8_t> query{
+			static_cast<uint8_t>(question.id >> 8),
+			static_cast<uint8_t>(question.id),
+			0x01, 0x00, // Recursion desired
+			0x00, 0x01, // One question
+			0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+		};
+		std::string_view name{host};
+		if (name.back() == '.')
+			name.remove_suffix(1);
+		while (!name.empty()) {
+			const auto dot = std::min(name.find('.'), name.size());
+			const auto label = name.substr(0, dot);
+			if (label.empty() || label.size() > 63)
+				return {};
+			query.push_back(static_cast<uint8_t>(label.size()));
+			query.insert(query.end(), label.begin(), label.end());
+			name.remove_prefix(std::min(dot + 1, name.size()));
+		}
+		query.insert(query.end(), {0x00,
+			static_cast<uint8_t>(question.type >> 8), static_cast<uint8_t>(question.type),
+			0x00, 0x01});
+		return query;
+	}
+	void sendAttempt() {
+		// Exchanges still open belong to the attempt that just timed out.
+		for (auto & question: questions)
+			this->closeExchange(question);
+		if (attempt >= attempts * static_cast<int>(nameservers.size())) {
+			// One family answering is enough, the other one just timed out.
+			const bool any = !found[0].empty() || !found[1].empty();
+			if (any)
+				return this->finish({});
+			if (serverFailed)
+				return this->finish(asio::error::host_not_found_try_again);
+			return this->finish(asio::error::timed_out);
+		}
+		server = nameservers[attempt % nameservers.size()];
+		++attempt;
+		if (!socket.is_open() || socketV6 != server.address().is_v6()) {
+			beast::error_code ec;
+			socket.close(ec);
+			socket.open(server.protocol(), ec);
+			if (ec)
+				return this->finish(ec);
+			socketV6 = server.address().is_v6();
+			this->receive();
+		}
+		for (auto & question: questions) {
+			if (question.done || question.overTcp)
+				continue;
+			if (question.query.empty())
+				return this->finish(asio::error::host_not_found);
+			socket.async_send_to(
+				asio::buffer(question.query),
+				server,
+				[self=this->shared_from_this()] (beast::error_code, std::size_t) {}
+			);
+		}
+		this->startTimer();
+	}
+	// Bounds both the UDP attempt and any TCP exchange started during it.
+	void startTimer() {
+		timer.expires_after(timeout);
+		timer.async_wait(
+			[self=this->shared_from_this()] (beast::error_code ec) {
+				if (ec || self->finished)
+					return;
+				self->sendAttempt();
+			}
+		);
+	}
+	void closeExchange(Question & question) {
+		if (!question.exchange)
+			return;
+		beast::error_code ignored;
+		question.exchange->socket.close(ignored);
+		question.exchange.reset();
+		question.overTcp = false;
+	}
+	void receive() {
+		socket.async_receive_from(
+			asio::buffer(datagram),
+			sender,
+			[self=this->shared_from_this()] (beast::error_code ec, std::size_t size) {
+				if (self->finished)
+					return;
+				if (ec == asio::error::operation_aborted)
+					return; // Socket reopened for another address family
+				if (!ec && self->fromNameserver(self->sender))
+					self->process(self->datagram.data(), size, false);
+				if (!self->finished && self->socket.is_open())
+					self->receive();
+			}
+		);
+	}
+	bool fromNameserver(const udp::endpoint & endpoint) const {
+		return std::find(nameservers.begin(), nameservers.end(), endpoint) != nameservers.end();
+	}
+	void process(const uint8_t * data, std::size_t size, bool overTcp) {
+		Question * question = nullptr;
+		const Answer answer = this->parse(data, size, question);
+		if (question == nullptr || question->done)
+			return;
+		switch (answer) {
+		case Answer::Records:
+			question->done = true;
 			break;
-		default:
+		case Answer::NameError:
+			question->done = true;
+			nameError = true;
 			break;
+		case Answer::Truncated:
+			if (!overTcp && !question->overTcp)
+				this->askOverTcp(*question);
+			return;
+		case Answer::Retry:
+			if (overTcp)
+				question->overTcp = false;
+			question->failedAttempt = attempt;
+			serverFailed = true;
+			// Once this server failed every open question, the next attempt
+			// starts right away instead of when the timer fires.
+			if (std::all_of(questions.begin(), questions.end(), [this] (const Question & q) { return q.done || q.failedAttempt == attempt; }))
+				this->sendAttempt();
+			return;
+		case Answer::Ignore:
+			if (overTcp)
+				question->overTcp = false; // Back to UDP on the next attempt
+			return;
 		}
+		if (std::all_of(questions.begin(), questions.end(), [] (const Question & q) { return q.done; }))
+			this->finish({});
 	}
-	void openWindow() {
-		std::cout << "Trying to open a window ..." << std::endl;
-		device = irr::createDevice(
-			irr::video::EDT_BURNINGSVIDEO,
-			irr::core::dimension2du{640, 360},
-			32,
-			false,
-			true,
-			true,
-			nullptr
+	void askOverTcp(Question & question) {
+		question.overTcp = true;
+		auto exchange = std::make_shared<Exchange>(Exchange{tcp::socket{socket.get_executor()}, {}, {}});
+		question.exchange = exchange;
+		exchange->message.reserve(question.query.size() + 2);
+		exchange->message.push_back(static_cast<uint8_t>(question.query.size() >> 8));
+		exchange->message.push_back(static_cast<uint8_t>(question.query.size()));
+		exchange->message.insert(exchange->message.end(), question.query.begin(), question.query.end());
+		// The TCP exchange gets a whole attempt timeout of its own.
+		this->startTimer();
+		auto self = this->shared_from_this();
+		// Ends this exchange, answered or not. An unanswered question goes
+		// back to UDP on the next attempt, unless a newer exchange took over.
+		auto close = [self, exchange, &question] {
+			if (question.exchange == exchange)
+				self->closeExchange(question);
+		};
+		exchange->socket.async_connect(
+			tcp::endpoint{server.address(), server.port()},
+			[self, exchange, close] (beast::error_code ec) {
+				if (ec || self->finished)
+					return close();
+				asio::async_write(
+					exchange->socket,
+					asio::buffer(exchange->message),
+					[self, exchange, close] (beast::error_code ec, std::size_t) {
+						if (ec || self->finished)
+							return close();
+						asio::async_read(
+							exchange->socket,
+							asio::buffer(exchange->length),
+							[self, exchange, close] (beast::error_code ec, std::size_t) {
+								if (ec || self->finished)
+									return close();
+								exchange->message.resize((exchange->length[0] << 8) | exchange->length[1]);
+								asio::async_read(
+									exchange->socket,
+									asio::buffer(exchange->message),
+									[self, exchange, close] (beast::error_code ec, std::size_t size) {
+										if (ec || self->finished)
+											return close();
+										self->process(exchange->message.data(), size, true);
+										close();
+									}
+								);
+							}
+						);
+					}
+				);
+			}
 		);
-		if (device != nullptr) {
-			opened = true;
-			this->obtainIrrlichtObjects();
+	}
+	// Skips a possibly compressed domain name, returns false when malformed.
+	static bool skipName(const uint8_t * data, std::size_t size, std::size_t & offset) {
+		while (offset < size) {
+			const uint8_t length = data[offset];
+			if (length == 0) {
+				++offset;
+				return true;
+			}
+			if ((length & 0xc0) == 0xc0) {
+				offset += 2;
+				return offset <= size;
+			}
+			offset += 1 + length;
 		}
+		return false;
 	}
-	void obtainIrrlichtObjects() {
-		device->setResizable(false);
-		device->setWindowCaption(L"Micburs Session Window");
-		smgr = device->getSceneManager();
-		igui = device->getGUIEnvironment();
-		driver = device->getVideoDriver();
-		fs = device->getFileSystem();
-		this->createWidgets();
+	Answer parse(const uint8_t * data, std::size_t size, Question * & question) {
+		if (size < 12)
+			return Answer::Ignore;
+		auto read16 = [data] (std::size_t at) {
+			return static_cast<std::uint16_t>((data[at] << 8) | data[at + 1]);
+		};
+		const std::uint16_t id = read16(0);
+		for (auto & candidate: questions)
+			if (candidate.id == id && !candidate.done)
+				question = &candidate;
+		const std::uint16_t flags = read16(2);
+		if (question == nullptr || (flags & 0x8000) == 0)
+			return Answer::Ignore;
+		// The echoed question must be ours, or the answer is not trusted.
+		const std::size_t questionSize = question->query.size() - 12;
+		if (read16(4) != 1 || size < 12 + questionSize
+			|| !std::equal(question->query.begin() + 12, question->query.end(), data + 12,
+				[] (uint8_t a, uint8_t b) { return std::tolower(a) == std::tolower(b); }))
+			return Answer::Ignore;
+		if (flags & 0x0200)
+			return Answer::Truncated;
+		const int rcode = flags & 0x000f;
+		if (rcode == 3)
+			return Answer::NameError;
+		if (rcode != 0)
+			return Answer::Retry;
+		std::size_t offset = 12 + questionSize;
+		const std::size_t answerCount = read16(6);
+		std::vector<tcp::endpoint> & records = found[question->type == typeAAAA ? 0 : 1];
+		for (std::size_t i=0; i<answerCount; ++i) {
+			if (!skipName(data, size, offset) || offset + 10 > size)
+				return Answer::Retry;
+			const std::uint16_t type = read16(offset);
+			const std::uint32_t ttl = (std::uint32_t{read16(offset + 4)} << 16) | read16(offset + 6);
+			const std::uint16_t length = read16(offset + 8);
+			offset += 10;
+			if (offset + length > size)
+				return Answer::Retry;
+			if (type == question->type && type == typeA && length == 4) {
+				asio::ip::address_v4::bytes_type bytes;
+				std::copy_n(data + offset, 4, bytes.begin());
+				records.emplace_back(asio::ip::address_v4{bytes}, portNumber);
+				minTtl = std::min(minTtl, ttl);
+			} else if (type == question->type && type == typeAAAA && length == 16) {
+				asio::ip::address_v6::bytes_type bytes;
+				std::copy_n(data + offset, 16, bytes.begin());
+				records.emplace_back(asio::ip::address_v6{bytes}, portNumber);
+				minTtl = std::min(minTtl, ttl);
+			} else if (type == typeCNAME) {
+				minTtl = std::min(minTtl, ttl);
+			}
+			offset += length;
+		}
+		return Answer::Records;
 	}
-	void createWidgets() {
-		fs->addFileArchive("./media");
-		irr::gui::IGUISkin * skin = igui->getSkin();
-		irr::gui::IGUIFont * font = igui->getFont("Liberation-Mono.1ASC.14-bold.xml");
-		skin->setFont(font);
-		std::wstring musicStatus;
-		if (music.getStatus() == sf::Sound::Playing)
-			musicStatus = L"Background Music Is Playing: true";
-		else
-			musicStatus = L"Background Music Is Playing: false";
-		irr::gui::IGUIStaticText * infoText = igui->addStaticText(
-			(
-				std::wstring(L"Light Blue: Host Resolved\nDark Blue: Host Connected\nGreen: HTTPS(TLS) Handshaked\nYellow: Reuqest sent\nLight: Https Server Responsed (All Finished!)\nRed 1: Network Exception\nRed 2: Program Exception\n\n") + musicStatus
-			).data(),
-			irr::core::recti{20, 20, 500, 340},
-			true,
-			true,
-			nullptr,
-			-1,
-			false
+	void finish(beast::error_code ec) {
+		if (finished)
+			return;
+		finished = true;
+		beast::error_code ignored;
+		timer.cancel();
+		socket.close(ignored);
+		for (auto & question: questions)
+			this->closeExchange(question);
+		std::vector<tcp::endpoint> endpoints = std::move(found[0]);
+		endpoints.insert(endpoints.end(), found[1].begin(), found[1].end());
+		if (!ec && endpoints.empty())
+			ec = nameError ? asio::error::host_not_found : asio::error::no_data;
+		const std::chrono::seconds ttl{endpoints.empty() ? 0 : minTtl};
+		handler(
+			ec,
+			ec ? Results{} : Results::create(endpoints.begin(), endpoints.end(), host, port),
+			ttl
 		);
-		infoText->setOverrideColor(irr::video::SColor{0xff584552});
-		windowThread = std::async(
-			std::launch::async,
-			&OpenWindow::startWindowLoop,
-			this
+	}
+};
+
+void DnsResolver::resolve(
+	Executor executor,
+	const std::string & host,
+	const std::string & port,
+	Handler handler
+) {
+	unsigned short portNumber = 0;
+	try {
+		portNumber = DnsResolver::parsePort(port);
+	} catch (std::invalid_argument &) {
+		asio::post(executor, [handler=std::move(handler)] {
+			handler(asio::error::invalid_argument, {}, {});
+		});
+		return;
+	}
+	beast::error_code ec;
+	std::vector<tcp::endpoint> endpoints;
+	const auto literal = asio::ip::make_address(host, ec);
+	if (!ec) {
+		endpoints.emplace_back(literal, portNumber);
+	} else if (host == "localhost") {
+		endpoints.emplace_back(asio::ip::address_v6::loopback(), portNumber);
+		endpoints.emplace_back(asio::ip::address_v4::loopback(), portNumber);
+	}
+	if (!endpoints.empty()) {
+		asio::post(
+			executor,
+			[handler=std::move(handler), results=Results::create(endpoints.begin(), endpoints.end(), host, port)] {
+				handler({}, results, std::chrono::seconds::max());
+			}
 		);
+		return;
+	}
+	std::make_shared<Lookup>(executor, host, port, portNumber, std::move(handler))->start();
+}
+
+// Shared front for all host lookups. Answers are kept for a TTL, failures
+// for a shorter negative TTL, and concurrent lookups of the same host:port
+// are joined, so 500 probes of one name cost a single lookup. Handlers are
+// always posted to the executor of the session that asked. Lookups go to
+// DnsResolver when it is enabled (then the record TTL is respected too),
+// otherwise to tcp::resolver.
+class ResolveCache {
+public:
+	using Results = tcp::resolver::results_type;
+	using Executor = asio::io_context::executor_type;
+	enum class Source {
+		Lookup, // This request did the lookup
+		Cache, // Answered from a stored entry
+		Shared // Joined a lookup that was already in flight
+	};
+	using Handler = std::function<void(beast::error_code, Results, Source)>;
+private:
+	struct Waiter {
+		Executor executor;
+		Handler handler;
+	};
+	struct Entry {
+		bool pending = false;
+		beast::error_code error;
+		Results results;
+		std::chrono::steady_clock::time_point expires;
+		std::vector<Waiter> waiters;
+	};
+	static inline std::chrono::seconds positiveTtl{60};
+	static inline std::chrono::seconds negativeTtl{10};
+	using Expiry = std::pair<std::chrono::steady_clock::time_point, std::string>;
+	std::mutex mutex;
+	std::unordered_map<std::string, Entry> entries;
+	// Soonest expiry first, one per completed lookup. An entry looked up
+	// again since has a later expiry of its own, so an outdated one is
+	// just dropped.
+	std::priority_queue<Expiry, std::vector<Expiry>, std::greater<>> expiries;
+	std::atomic<std::size_t> lookupCount = 0;
+	std::atomic<std::size_t> cacheCount = 0;
+	std::atomic<std::size_t> sharedCount = 0;
+public:
+	// Must be called before the first instance(). A positive TTL of 0
+	// disables caching, concurrent lookups are still joined.
+	static void configure(std::chrono::seconds ttl, std::chrono::seconds negativeTtl) {
+		positiveTtl = ttl;
+		ResolveCache::negativeTtl = negativeTtl;
+	}
+	static ResolveCache & instance() {
+		static ResolveCache cache;
+		return cache;
+	}
+	static const char * sourceString(Source source) {
+		switch (source) {
+		case Source::Lookup:
+			return "lookup";
+		case Source::Cache:
+			return "cache";
+		case Source::Shared:
+			return "shared";
+		}
+		return "unknown";
+	}
+	std::size_t lookups() const {
+		return lookupCount;
+	}
+	std::size_t cacheHits() const {
+		return cacheCount;
+	}
+	std::size_t sharedHits() const {
+		return sharedCount;
+	}
+	void resolve(
+		Executor executor,
+		const std::string & host,
+		const std::string & port,
+		Handler handler
+	) {
+		std::string key = host + ':' + port;
+		const auto now = std::chrono::steady_clock::now();
+		std::unique_lock lock{mutex};
+		Entry & entry = entries[key];
+		if (entry.pending) {
+			++sharedCount;
+			entry.waiters.push_back({executor, std::move(handler)});
+			return;
+		}
+		if (entry.expires > now) {
+			++cacheCount;
+			asio::post(
+				executor,
+				recycled([handler=std::move(handler), error=entry.error, results=entry.results] {
+					handler(error, results, Source::Cache);
+				})
+			);
+			return;
+		}
+		++lookupCount;
+		entry.pending = true;
+		entry.waiters.push_back({executor, std::move(handler)});
+		this->sweep(now);
+		lock.unlock();
+		if (DnsResolver::enabled()) {
+			DnsResolver::resolve(
+				executor,
+				host,
+				port,
+				[this, key=std::move(key)] (
+					beast::error_code ec,
+					Results results,
+					std::chrono::seconds ttl
+				) {
+					this->complete(key, ec, std::move(results), ttl);
+				}
+			);
+			return;
+		}
+		auto resolver = std::make_shared<tcp::resolver>(executor);
+		resolver->async_resolve(
+			host,
+			port,
+			[this, key=std::move(key), resolver] (
+				beast::error_code ec,
+				Results results
+			) {
+				this->complete(key, ec, std::move(results), std::chrono::seconds::max());
+			}
+		);
+	}
+private:
+	void complete(
+		const std::string & key,
+		beast::error_code ec,
+		Results results,
+		std::chrono::seconds recordTtl
+	) {
+		std::vector<Waiter> waiters;
+		{
+			std::lock_guard lock{mutex};
+			Entry & entry = entries[key];
+			waiters.swap(entry.waiters);
+			entry.pending = false;
+			entry.error = ec;
+			entry.results = results;
+			// A cancelled lookup says nothing about the host.
+			if (ec == asio::error::operation_aborted)
+				entry.expires = {};
+			else
+				entry.expires = std::chrono::steady_clock::now() + (ec ? negativeTtl : std::min(recordTtl, positiveTtl));
+			expiries.emplace(entry.expires, key);
+		}
+		bool first = true;
+		for (auto & waiter: waiters) {
+			const Source source = first ? Source::Lookup : Source::Shared;
+			first = false;
+			asio::post(
+				waiter.executor,
+				recycled([handler=std::move(waiter.handler), ec, results, source] {
+					handler(ec, results, source);
+				})
+			);
+		}
+	}
+	// Called with the mutex held. Only visits the entries that expired.
+	void sweep(std::chrono::steady_clock::time_point now) {
+		while (!expiries.empty() && expiries.top().first <= now) {
+			auto iter = entries.find(expiries.top().second);
+			if (iter != entries.end() && !iter->second.pending && iter->second.expires <= now)
+				entries.erase(iter);
+			expiries.pop();
+		}
+	}
+};
+
+// Staggered parallel connect for dual-stack targets (RFC 8305). Endpoints
+// are interleaved by address family, a new attempt starts every
+// `attemptDelay` or as soon as the previous one fails, the first connected
+// socket wins and all other attempts are cancelled.
+class HappyEyeballs: public std::enable_shared_from_this<HappyEyeballs> {
+public:
+	using Socket = beast::tcp_stream::socket_type;
+	using Handler = std::function<void(beast::error_code, Socket &&, tcp::endpoint)>;
+private:
+	std::vector<tcp::endpoint> endpoints;
+	std::vector<std::unique_ptr<Socket>> attempts;
+	asio::steady_timer staggerTimer;
+	asio::steady_timer deadlineTimer;
+	const std::chrono::milliseconds attemptDelay;
+	Handler handler;
+	std::size_t nextEndpoint = 0;
+	std::size_t running = 0;
+	beast::error_code lastError = asio::error::host_not_found;
+	bool finished = false;
+public:
+	HappyEyeballs(
+		asio::io_context::executor_type executor,
+		const tcp::resolver::results_type & results,
+		std::chrono::milliseconds attemptDelay,
+		Handler handler
+	)
+	:
+		staggerTimer{executor},
+		deadlineTimer{executor},
+		attemptDelay{attemptDelay},
+		handler{std::move(handler)}
+	{
+		std::vector<tcp::endpoint> first;
+		std::vector<tcp::endpoint> second;
+		for (const auto & entry: results) {
+			const bool sameFamily = first.empty() || first.front().protocol() == entry.endpoint().protocol();
+			(sameFamily ? first : second).push_back(entry.endpoint());
+		}
+		for (std::size_t i=0; i<std::max(first.size(), second.size()); ++i) {
+			if (i < first.size())
+				endpoints.push_back(first[i]);
+			if (i < second.size())
+				endpoints.push_back(second[i]);
+		}
+	}
+	void start(std::chrono::steady_clock::duration timeout) {
+		deadlineTimer.expires_after(timeout);
+		deadlineTimer.async_wait(
+			recycled([self=this->shared_from_this()] (beast::error_code ec) {
+				if (!ec)
+					self->finish(beast::error::timeout, nullptr, {});
+			})
+		);
+		this->startNext();
+	}
+private:
+	void startNext() {
+		if (finished)
+			return;
+		if (nextEndpoint >= endpoints.size()) {
+			if (running == 0)
+				this->finish(lastError, nullptr, {});
+			return;
+		}
+		const tcp::endpoint endpoint = endpoints[nextEndpoint++];
+		Socket & socket = *attempts.emplace_back(std::make_unique<Socket>(staggerTimer.get_executor()));
+		++running;
+		socket.async_connect(
+			endpoint,
+			recycled([self=this->shared_from_this(), &socket, endpoint] (beast::error_code ec) {
+				--self->running;
+				if (self->finished)
+					return;
+				if (!ec)
+					return self->finish({}, &socket, endpoint);
+				self->lastError = ec;
+				// A failed attempt starts the next one right away.
+				self->staggerTimer.cancel();
+				self->startNext();
+			})
+		);
+		staggerTimer.expires_after(attemptDelay);
+		staggerTimer.async_wait(
+			recycled([self=this->shared_from_this()] (beast::error_code ec) {
+				if (!ec)
+					self->startNext();
+			})
+		);
+	}
+	void finish(beast::error_code ec, Socket * winner, tcp::endpoint endpoint) {
+		if (finished)
+			return;
+		finished = true;
+		staggerTimer.cancel();
+		deadlineTimer.cancel();
+		beast::error_code ignored;
+		for (auto & attempt: attempts)
+			if (attempt.get() != winner)
+				attempt->close(ignored);
+		if (winner)
+			handler(ec, std::move(*winner), endpoint);
+		else
+			handler(ec, Socket{staggerTimer.get_executor()}, endpoint);
+	}
+};
+
+// The parts of a TLS connection that do not depend on the peer. Seeding an
+// AutoSeeded_RNG reads the system entropy source, so it is done once per
+// io_context instead of once per connection. Like the ConnectionPool it is
+// only used by the thread running its io_context, which is all Botan's RNG
+// asks for.
+class TlsEssentials: public asio::execution_context::service {
+public:
+	// Which TLS::Policy the client offers, chosen with --tls-profile.
+	enum class Profile {
+		Compatible, // Botan's default policy
+		Fast, // TLS 1.3 only, X25519, the cheapest AEAD for this CPU first
+		Strict // Botan's Strict_Policy
+	};
+private:
+	static inline Profile profile = Profile::Compatible;
+public:
+	CredentialsManager credMan;
+	Botan::AutoSeeded_RNG rng;
+	const std::unique_ptr<TLS::Policy> policy{makePolicy(profile)};
+public:
+	inline static asio::execution_context::id id;
+	explicit TlsEssentials(asio::execution_context & context)
+	:
+		asio::execution_context::service{context}
+	{
+	}
+	// Must be called before any session starts.
+	static void configure(Profile _profile_) {
+		profile = _profile_;
+	}
+	static Profile parseProfile(const std::string & name) {
+		if (name == "compatible")
+			return Profile::Compatible;
+		if (name == "fast")
+			return Profile::Fast;
+		if (name == "strict")
+			return Profile::Strict;
+		throw std::runtime_error{"Unknown TLS profile: " + name};
+	}
+	static const char * profileName(Profile profile) {
+		switch (profile) {
+		case Profile::Compatible:
+			return "compatible";
+		case Profile::Fast:
+			return "fast";
+		case Profile::Strict:
+			return "strict";
+		}
+		return "unknown";
+	}
+	// Fast keeps the handshake to one round trip and one X25519 key share,
+	// and puts AES-GCM first where the CPU has AES instructions, otherwise
+	// ChaCha20-Poly1305, which is faster in software.
+	static std::unique_ptr<TLS::Policy> makePolicy(Profile profile) {
+		switch (profile) {
+		case Profile::Compatible:
+			return std::make_unique<TLS::Policy>();
+		case Profile::Strict:
+			return std::make_unique<TLS::Strict_Policy>();
+		case Profile::Fast:
+			return std::make_unique<TLS::Text_Policy>(
+				"allow_tls12 = false\n"
+				"allow_tls13 = true\n"
+				"ciphers = "s + (Botan::CPUID::has_hw_aes()
+					? "AES-128/GCM AES-256/GCM ChaCha20Poly1305"
+					: "ChaCha20Poly1305 AES-128/GCM AES-256/GCM") + "\n"
+				"macs = AEAD\n"
+				"key_exchange_methods = ECDH\n"
+				"key_exchange_groups = x25519 secp256r1\n"
+				"key_exchange_groups_to_offer = x25519\n"
+				"signature_methods = ECDSA RSA\n"
+				"signature_hashes = SHA-256 SHA-384\n"
+			);
+		}
+		return std::make_unique<TLS::Policy>();
+	}
+private:
+	void shutdown() override {
+	}
+};
+
+// Everything one TLS connection needs besides its io_context's
+// TlsEssentials. TLS::Context and the stream keep references into the other
+// members, so they have to travel together when a connection outlives its
+// AppSession in the ConnectionPool.
+class TlsConnection {
+public:
+	SessionCacheView sessionMan;
+	TLS::Server_Information serverInformation;
+	TLS::Context tlsContext;
+	TLS::Stream<beast::tcp_stream> stream;
+	std::chrono::steady_clock::time_point idleSince;
+public:
+	TlsConnection(
+		asio::io_context & ioContext,
+		TlsEssentials & essentials,
+		const std::string & host,
+		const std::string & port
+	)
+	:
+		sessionMan{SharedSessionCache::instance()},
+		serverInformation{host, port},
+		tlsContext{essentials.credMan, essentials.rng, sessionMan, *essentials.policy, serverInformation},
+		stream{tlsContext, ioContext}
+	{
+		if (VerifiedChainCache::enabled())
+			tlsContext.set_verify_callback(
+				std::bind(
+					&VerifiedChainCache::verify,
+					&VerifiedChainCache::instance(),
+					_1, _2, _3, _4, _5, _6
+				)
+			);
+	}
+	// True when the peer has neither closed the connection nor sent anything
+	// unasked. Never blocks.
+	bool healthy() {
+		auto & socket = stream.next_layer().socket();
+		if (!socket.is_open())
+			return false;
+		beast::error_code ec;
+		socket.non_blocking(true, ec);
+		std::array<char, 1> peek;
+		socket.receive(asio::buffer(peek), tcp::socket::message_peek, ec);
+		beast::error_code ignored;
+		socket.non_blocking(false, ignored);
+		return ec == asio::error::would_block;
+	}
+};
+
+// Idle keep-alive connections of one io_context, keyed by host:port and
+// reached through asio::use_service. Only the thread running that
+// io_context touches it, so there is no lock at all. IoContextPool::
+// acquireFor() prefers one io_context per host:port so its connections are
+// found again, but spreads a busy host over all of them; every io_context
+// may then keep up to maxIdlePerHost connections of that host.
+class ConnectionPool: public asio::execution_context::service {
+private:
+	static inline std::size_t maxIdlePerHost = 0;
+	static inline std::chrono::seconds idleTimeout{30};
+	std::unordered_map<std::string, std::vector<std::unique_ptr<TlsConnection>>> idle;
+	std::size_t checkins = 0;
+public:
+	inline static asio::execution_context::id id;
+	explicit ConnectionPool(asio::execution_context & context)
+	:
+		asio::execution_context::service{context}
+	{
+	}
+	// Must be called before any session starts, 0 disables keep-alive.
+	static void configure(std::size_t maxIdle, std::chrono::seconds timeout) {
+		maxIdlePerHost = maxIdle;
+		idleTimeout = timeout;
+	}
+	static bool enabled() {
+		return maxIdlePerHost > 0;
+	}
+	// Most recently used first, stale and dead connections are dropped.
+	std::unique_ptr<TlsConnection> checkout(const std::string & key) {
+		auto iter = idle.find(key);
+		if (iter == idle.end())
+			return nullptr;
+		auto & connections = iter->second;
+		const auto now = std::chrono::steady_clock::now();
+		while (!connections.empty()) {
+			std::unique_ptr<TlsConnection> connection = std::move(connections.back());
+			connections.pop_back();
+			if (now - connection->idleSince < idleTimeout && connection->healthy())
+				return connection;
+		}
+		idle.erase(iter);
+		return nullptr;
+	}
+	void checkin(const std::string & key, std::unique_ptr<TlsConnection> connection) {
+		const auto now = std::chrono::steady_clock::now();
+		if (++checkins % 256 == 0)
+			this->sweep(now);
+		connection->stream.next_layer().expires_never();
+		connection->idleSince = now;
+		auto & connections = idle[key];
+		if (connections.size() >= maxIdlePerHost)
+			connections.erase(connections.begin());
+		connections.push_back(std::move(connection));
+	}
+private:
+	void sweep(std::chrono::steady_clock::time_point now) {
+		for (auto iter = idle.begin(); iter != idle.end();) {
+			auto & connections = iter->second;
+			std::erase_if(connections, [&] (const auto & connection) {
+				return now - connection->idleSince >= idleTimeout;
+			});
+			if (connections.empty())
+				iter = idle.erase(iter);
+			else
+				++iter;
+		}
+	}
+	void shutdown() override {
+		idle.clear();
+	}
+};
+
+// HDR style latency histogram in microseconds. Values below 2^SubBucketBits
+// are exact, above that every power of two is split into 2^(SubBucketBits-1)
+// linear sub-buckets, so a reported value is never more than
+// 2^-(SubBucketBits-1) above the recorded one. Anything up to about 19 hours
+// fits. Recording is one relaxed atomic increment, so all io_context threads
+// record into the same histogram without a lock.
+template <unsigned SubBucketBits>
+class LatencyHistogram {
+private:
+	static constexpr unsigned valueBits = 36;
+	static constexpr std::uint64_t subBucketCount = std::uint64_t{1} << SubBucketBits;
+	static constexpr std::uint64_t halfCount = subBucketCount / 2;
+	static constexpr std::uint64_t maxValue = (std::uint64_t{1} << valueBits) - 1;
+	static constexpr std::size_t bucketCount = subBucketCount + (valueBits - SubBucketBits) * halfCount;
+	std::array<std::atomic<std::uint32_t>, bucketCount> buckets{};
+	std::atomic<std::uint64_t> total = 0;
+	std::atomic<std::uint64_t> maximum = 0;
+	static std::size_t indexOf(std::uint64_t value) {
+		if (value < subBucketCount)
+			return value;
+		const unsigned shift = std::bit_width(value) - SubBucketBits;
+		return subBucketCount + (shift - 1) * halfCount + ((value >> shift) - halfCount);
+	}
+	// Highest value that falls into bucket `index`.
+	static std::uint64_t valueOf(std::size_t index) {
+		if (index < subBucketCount)
+			return index;
+		const std::uint64_t offset = index - subBucketCount;
+		const unsigned shift = offset / halfCount + 1;
+		const std::uint64_t subBucket = offset % halfCount + halfCount;
+		return ((subBucket + 1) << shift) - 1;
+	}
+public:
+	void record(std::chrono::steady_clock::duration duration) {
+		const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+		const std::uint64_t value = std::min<std::uint64_t>(micros > 0 ? micros : 0, maxValue);
+		buckets[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+		total.fetch_add(1, std::memory_order_relaxed);
+		std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+		while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+			;
+	}
+	std::uint64_t count() const {
+		return total.load(std::memory_order_relaxed);
+	}
+	std::chrono::microseconds max() const {
+		return std::chrono::microseconds(maximum.load(std::memory_order_relaxed));
+	}
+	// quantile in [0, 1], e.g. 0.999 for p99.9.
+	std::chrono::microseconds percentile(double quantile) const {
+		const std::uint64_t wanted = std::max<std::uint64_t>(1, std::ceil(quantile * this->count()));
+		std::uint64_t seen = 0;
+		for (std::size_t i=0; i<bucketCount; ++i) {
+			seen += buckets[i].load(std::memory_order_relaxed);
+			if (seen >= wanted)
+				return std::chrono::microseconds(std::min(valueOf(i), maximum.load(std::memory_order_relaxed)));
+		}
+		return this->max();
+	}
+};
+
+// What is read of each response. Every mode keeps per-session memory
+// constant: bodies are streamed through one fixed buffer and discarded.
+enum class ProbeMode {
+	Body, // GET, read the whole body (up to maxBody)
+	Head, // HEAD, header only, the connection stays usable
+	Headers // GET, stop after the first header and close
+};
+
+struct ProbeOptions {
+	// Verbose sessions print network errors and the whole response (GUI mode).
+	bool verbose = true;
+	ProbeMode mode = ProbeMode::Body;
+	// Stop reading a body after this many bytes, 0 reads it all.
+	std::uint64_t maxBody = 0;
+	// Size of the buffer a body is streamed through.
+	std::size_t bodyBuffer = 16 * 1024;
+	// Botan hash of every body (e.g. "SHA-256", "BLAKE2b(256)"), empty for none.
+	std::string digest;
+	std::chrono::seconds timeout{12};
+	// Happy Eyeballs connection attempt delay, 0 tries endpoints one by one.
+	std::chrono::milliseconds connectAttemptDelay{250};
+	// Run the probe as one asio::awaitable coroutine instead of the
+	// callback chain.
+	bool coroutine = false;
+	// Request targets, pipelined back-to-back on one connection.
+	std::vector<std::string> paths{"/"};
+};
+
+struct PathResult {
+	std::string target;
+	unsigned httpStatus = 0;
+	std::chrono::steady_clock::duration latency{}; // Requests sent -> this response read
+	std::chrono::steady_clock::duration ttfb{}; // Requests sent or previous response -> header
+	std::chrono::steady_clock::duration body{}; // Header -> whole response read
+	std::uint64_t bodyBytes = 0;
+	bool truncated = false; // Body not read to the end (maxBody or Headers mode)
+	std::string digest{}; // Hex digest of the bytes read, if asked for
+	double throughput() const { // Body bytes per second
+		const std::chrono::duration<double> seconds = body;
+		return seconds.count() > 0 ? bodyBytes / seconds.count() : 0;
+	}
+};
+
+struct ProbeResult {
+	std::string host;
+	std::string port;
+	SigMan::NetStat stat = SigMan::NetStat::ProgramStarted; // Last phase reached
+	// Monotonic time of every NetStat transition, indexed by the NetStat.
+	std::array<
+		std::chrono::steady_clock::time_point,
+		std::to_underlying(SigMan::NetStat::CppGeneralException) + 1
+	> reachedAt{};
+	bool failed = false;
+	std::string what;
+	beast::error_code error;
+	unsigned httpStatus = 0; // Status of the first response
+	std::vector<PathResult> paths; // One per response read, in request order
+	SessionCacheView::Resumption resumption = SessionCacheView::Resumption::Full; // From SharedSessionCache
+	std::uint16_t tlsVersion = 0; // Protocol_Version code, 0 if not learnt
+	ResolveCache::Source dnsSource = ResolveCache::Source::Lookup;
+	std::chrono::steady_clock::duration resolve{}; // Start -> Resolved
+	std::chrono::steady_clock::duration connect{}; // Resolved -> Connected
+	bool reused = false; // Request sent on a pooled keep-alive connection
+	tcp::endpoint peer; // The address the connection was made to
+	std::chrono::steady_clock::duration handshake{}; // Connected -> Handshaked
+	std::chrono::steady_clock::duration elapsed{};
+};
+
+std::ostream & operator<<(std::ostream & out, const ProbeResult & result) {
+	const auto ms = std::chrono::duration<double, std::milli>{result.elapsed}.count();
+	out << result.host << ':' << result.port
+		<< (result.failed ? " FAIL " : " OK ")
+		<< SigMan::NetStatusString(result.stat);
+	out << std::fixed << std::setprecision(1);
+	if (result.paths.size() > 1)
+		for (const auto & path: result.paths)
+			out << ' ' << path.target << '=' << path.httpStatus
+				<< '(' << std::chrono::duration<double, std::milli>{path.latency}.count() << "ms"
+				<< (path.digest.empty() ? "" : ",") << path.digest << ')';
+	else if (result.httpStatus != 0)
+		out << " http=" << result.httpStatus
+			<< " ttfb=" << std::chrono::duration<double, std::milli>{result.paths.front().ttfb}.count() << "ms"
+			<< " body=" << std::chrono::duration<double, std::milli>{result.paths.front().body}.count() << "ms"
+			<< " bytes=" << result.paths.front().bodyBytes
+			<< (result.paths.front().truncated ? " truncated" : "")
+			<< " rate=" << result.paths.front().throughput() / 1e6 << "MB/s"
+			<< (result.paths.front().digest.empty() ? "" : " digest=") << result.paths.front().digest;
+	if (result.resolve.count() != 0)
+		out << " dns=" << std::chrono::duration<double, std::milli>{result.resolve}.count() << "ms("
+			<< ResolveCache::sourceString(result.dnsSource) << ')';
+	if (result.connect.count() != 0)
+		out << " connect=" << std::chrono::duration<double, std::milli>{result.connect}.count() << "ms"
+			<< " peer=" << result.peer;
+	if (result.handshake.count() != 0)
+		out << " tls=" << std::chrono::duration<double, std::milli>{result.handshake}.count() << "ms"
+			<< ' ' << SessionCacheView::resumptionString(result.resumption);
+	if (result.tlsVersion != 0)
+		out << " version=" << tlsVersionString(result.tlsVersion);
+	if (result.reused)
+		out << " reused";
+	out << " time=" << ms << "ms";
+	if (result.failed) {
+		out << " error=\"" << result.what;
+		if (result.error)
+			out << ": " << result.error.message();
+		out << '"';
+	}
+	return out;
+}
+
+ResultStore::Row ResultStore::Row::of(const ProbeResult & result) {
+	auto ms = [] (std::chrono::steady_clock::duration duration) {
+		return duration.count() == 0
+			? std::numeric_limits<float>::quiet_NaN()
+			: std::chrono::duration<float, std::milli>{duration}.count();
+	};
+	const bool responded = !result.paths.empty();
+	return {
+		result.host + ':' + result.port,
+		result.stat,
+		result.failed,
+		{
+			ms(result.resolve),
+			ms(result.connect),
+			ms(result.handshake),
+			responded ? ms(result.paths.front().ttfb) : ms({}),
+			responded ? ms(result.paths.front().body) : ms({}),
+			ms(result.elapsed)
+		},
+		result.tlsVersion,
+		static_cast<std::uint16_t>(result.httpStatus)
+	};
+}
+
+// One LatencyHistogram per probe phase.
+template <unsigned SubBucketBits>
+class PhaseHistograms {
+public:
+	enum Phase {
+		Dns,
+		Connect,
+		Tls,
+		Ttfb,
+		Body,
+		phaseCount
+	};
+private:
+	std::array<LatencyHistogram<SubBucketBits>, phaseCount> phases;
+public:
+	static const char * phaseName(int phase) {
+		static const char * names[phaseCount] = {"dns", "connect", "tls", "ttfb", "body"};
+		return names[phase];
 	}
-	void startWindowLoop() {
-		while (device->run()) {
-			driver->beginScene(
-				irr::video::ECBF_COLOR | irr::video::ECBF_DEPTH,
-				irr::video::SColor{std::to_underlying(color.load())}
-			);
-			smgr->drawAll();
-			igui->drawAll();
-			driver->endScene();
+	// Phases a probe skipped (e.g. on a reused connection) are not recorded.
+	void record(const ProbeResult & result) {
+		if (result.resolve.count() != 0)
+			phases[Dns].record(result.resolve);
+		if (result.connect.count() != 0)
+			phases[Connect].record(result.connect);
+		if (result.handshake.count() != 0)
+			phases[Tls].record(result.handshake);
+		for (const auto & path: result.paths) {
+			phases[Ttfb].record(path.ttfb);
+			phases[Body].record(path.body);
 		}
-		device->drop();
-		device = nullptr;
-		if (attached) {
-			this->detach();
-			attached = false;
-			std::cout << "Detaching boost::signals2 from session window ..."
-				<< std::endl;
+	}
+	void print(std::ostream & out, const char * indent) const {
+		auto ms = [] (std::chrono::microseconds value) {
+			return value.count() / 1000.0;
+		};
+		out << std::fixed << std::setprecision(2);
+		for (int phase=0; phase<phaseCount; ++phase) {
+			const auto & histogram = phases[phase];
+			if (histogram.count() == 0)
+				continue;
+			out << indent << std::setw(8) << std::left << phaseName(phase) << std::right
+				<< " n=" << histogram.count()
+				<< " p50=" << ms(histogram.percentile(0.5)) << "ms"
+				<< " p90=" << ms(histogram.percentile(0.9)) << "ms"
+				<< " p99=" << ms(histogram.percentile(0.99)) << "ms"
+				<< " p999=" << ms(histogram.percentile(0.999)) << "ms"
+				<< " max=" << ms(histogram.max()) << "ms" << '\n';
 		}
-		std::cout << "Session window closed, boost::signals2 detached!\n";
 	}
 };
 
-class AppSession: public std::enable_shared_from_this<AppSession>, private MessageTarget {
+// Lets a move-only completion handler, such as a coroutine's, be stored in
+// the std::function callbacks of ResolveCache and HappyEyeballs.
+template <typename Handler>
+auto copyableHandler(Handler && handler) {
+	return [shared=std::make_shared<std::decay_t<Handler>>(std::forward<Handler>(handler))] (auto && ... args) {
+		(*shared)(std::forward<decltype(args)>(args)...);
+	};
+}
+
+// One probe at a time: SessionPool hands out an AppSession, reset() points
+// it at a target, and once the last shared_ptr is gone it goes back to the
+// pool with its buffers, digest and request ready for the next target.
+class AppSession: public std::enable_shared_from_this<AppSession> {
+public:
+	using FinishHandler = std::function<void(const ProbeResult &)>;
 private:
 // Private members for boost::beast/asio session.
-	const std::string host;
-	const std::string port;
-	asio::io_context ioContext;
-	tcp::resolver resolver;
-	std::shared_ptr<AppSession> self;
+	std::string host;
+	std::string port;
+	std::string poolKey;
+	asio::io_context & ioContext;
+	std::shared_ptr<AppSession> self; // Keeps the callback chain alive
 private:
-// Private members for Botan::TLS session.
-	CredentialsManager credMan;
-	Botan::AutoSeeded_RNG rng;
-	TLS::Session_Manager_In_Memory sessionMan;
-	TLS::Policy policy;
-	TLS::Server_Information serverInformation;
-	TLS::Context tlsContext;
-	TLS::Stream<beast::tcp_stream> tlsStream;
+// Private members for Botan::TLS session, created in start() or taken from
+// the ConnectionPool.
+	std::unique_ptr<TlsConnection> connection;
+	ConnectionPool & connectionPool;
+	TlsEssentials & tlsEssentials;
+	bool retried = false;
 private:
-// Private members for beast::http
-	http::request<http::empty_body> req;
-	http::response<http::string_body> res;
+// Private members for beast::http. Header fields take their nodes from
+// HandlerMemory, so a recycled session parses without the heap.
+	using Fields = http::basic_fields<RecyclingAllocator<char>>;
+	http::request<http::empty_body, Fields> req;
+	std::optional<http::response_parser<http::buffer_body, RecyclingAllocator<char>>> parser;
+	std::unique_ptr<char[]> bodyBuffer; // Every body chunk lands here
+	std::size_t bodyBufferSize = 0;
+	std::uint64_t bodyBytes = 0;
+	static constexpr std::size_t maxDigestLength = 64;
+	std::unique_ptr<Botan::HashFunction> digest; // Fed chunk by chunk, reused per response
+	std::string digestName; // options->digest that digest was made for
 	beast::flat_buffer buffer;
+	beast::flat_buffer pipeline; // All requests, serialized back-to-back
+	std::size_t responsesRead = 0;
+	std::chrono::steady_clock::time_point requestStart;
+	std::chrono::steady_clock::time_point responseStart; // Requests sent or previous response read
+	std::chrono::steady_clock::time_point headerTime;
 private:
-	SigMan & circleSigMan;
+	std::shared_ptr<SigMan::Topic> topic;
+	std::shared_ptr<const ProbeOptions> options;
+	ProbeResult result;
+	FinishHandler onFinished;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point connectStart;
+	std::chrono::steady_clock::time_point handshakeStart;
 public:
-	AppSession(
-		const std::string & _host_,
-		const std::string & _port_,
-		SigMan & _sigMan_
-	)
+	explicit AppSession(asio::io_context & _ioContext_)
 	:
-		host{_host_},
-		port{_port_},
-		ioContext{},
-		resolver{ioContext},
-		credMan{},
-		rng{},
-		sessionMan{rng},
-		policy{},
-		serverInformation{host, port},
-		tlsContext{credMan, rng, sessionMan, policy, serverInformation},
-		tlsStream{tlsContext, ioContext},
-		circleSigMan{_sigMan_}
+		ioContext{_ioContext_},
+		connectionPool{asio::use_service<ConnectionPool>(ioContext)},
+		tlsEssentials{asio::use_service<TlsEssentials>(ioContext)}
 	{
-		this->attach(_sigMan_);
-	}
-	~AppSession() {
-		this->detach();
+		req.version(11);
+		req.set(http::field::user_agent, "Botan::TLS-boost::beast-Session-"s + BOOST_BEAST_VERSION_STRING);
 	}
-	// todo: Probably not working on "SigMan::NetStat::PleaseClose"
-	void update(SigMan::NetStat stat) override {
-		if (stat == SigMan::NetStat::PleaseClose) {
-			std::cout << "VVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVVV\n";
-			std::cout << "\"class AppSession\" Received PleaseClose:\n\t"
-				<< SigMan::NetStatusString(stat)
-				<< std::endl;
-		} else {
-			std::cout << "++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++\n";
-			std::cout << "Other Message:\n\t"
-				<< SigMan::NetStatusString(stat) << std::endl;
+	AppSession(const AppSession &) = delete;
+	AppSession & operator=(const AppSession &) = delete;
+	// Points the session at its next target. Only the per-target state is
+	// reset; the body buffer is kept while it is big enough and the digest
+	// while the algorithm stays the same.
+	void reset(
+		const std::string & _host_,
+		const std::string & _port_,
+		std::shared_ptr<SigMan::Topic> _topic_,
+		std::shared_ptr<const ProbeOptions> _options_,
+		FinishHandler _onFinished_ = {}
+	) {
+		if (_options_->digest != digestName) {
+			digest.reset();
+			digestName.clear();
+			if (!_options_->digest.empty()) {
+				auto created = Botan::HashFunction::create_or_throw(_options_->digest);
+				if (created->output_length() > maxDigestLength)
+					throw std::runtime_error{"Digest too long: " + _options_->digest};
+				digest = std::move(created);
+			}
+			digestName = _options_->digest;
 		}
+		if (bodyBufferSize < _options_->bodyBuffer) {
+			bodyBuffer.reset();
+			bodyBufferSize = 0;
+		}
+		host = _host_;
+		port = _port_;
+		poolKey.assign(host).append(1, ':').append(port);
+		topic = std::move(_topic_);
+		options = std::move(_options_);
+		onFinished = std::move(_onFinished_);
+		retried = false;
+		buffer.clear();
+		responsesRead = 0;
+		auto paths = std::move(result.paths);
+		paths.clear();
+		result = ProbeResult{};
+		result.paths = std::move(paths);
+		result.host = host;
+		result.port = port;
+	}
+	// Lets go of everything that belongs to the finished target, called by
+	// SessionPool before the session waits for the next one.
+	void release() {
+		connection.reset();
+		parser.reset();
+		topic.reset();
+		options.reset();
+		onFinished = nullptr;
 	}
+	// Starts the resolve/connect/handshake/write/read chain on ioContext,
+	// must be called from the thread running ioContext. With keep-alive, a
+	// live pooled connection skips straight to the request. The session
+	// keeps itself alive until the chain finishes or fails, so the caller
+	// does not need to hold the shared_ptr.
 	void start() {
+		startTime = std::chrono::steady_clock::now();
+		result.reachedAt[std::to_underlying(SigMan::NetStat::ProgramStarted)] = startTime;
+		if (ConnectionPool::enabled())
+			connection = connectionPool.checkout(poolKey);
+		result.reused = connection != nullptr;
+		if (options->coroutine)
+			return asio::co_spawn(ioContext, this->probe(this->shared_from_this()), asio::detached);
+		self = this->shared_from_this();
+		if (connection)
+			return self->write();
+		self->connectFresh();
+	}
+private:
+// Steps shared by the callback chain and the coroutine.
+	void reach(SigMan::NetStat stat) {
+		result.stat = stat;
+		result.reachedAt[std::to_underlying(stat)] = std::chrono::steady_clock::now();
+		topic->publish(stat);
+	}
+	bool createConnection() {
+		buffer.clear();
 		try {
-			self = this->shared_from_this();
-			self->resolve();
-			ioContext.run();
-			std::cout << "************************************************************************\n";
-			std::cout << "Network Session Closed!\n";
+			connection = std::make_unique<TlsConnection>(ioContext, tlsEssentials, host, port);
 		} catch (std::exception & exc) {
-			std::cerr << "[Network Exception]" << exc.what() << std::endl;
-			circleSigMan.update(SigMan::NetStat::NetworkException);
+			result.failed = true;
+			result.what = "Session Setup Error: "s + exc.what();
+			result.stat = SigMan::NetStat::CppGeneralException;
+			topic->publish(SigMan::NetStat::CppGeneralException);
+			return false;
+		}
+		return true;
+	}
+	// The server may have closed an idle connection just now, so a pooled
+	// connection that fails gets one retry on a fresh one.
+	bool retryOnFreshConnection() {
+		if (!result.reused || retried)
+			return false;
+		retried = true;
+		result.reused = false;
+		connection.reset();
+		return true;
+	}
+	void recordFailure(beast::error_code ec, const char * what) {
+		result.failed = true;
+		result.error = ec;
+		result.what = what;
+		result.reachedAt[std::to_underlying(SigMan::NetStat::NetworkException)] = std::chrono::steady_clock::now();
+		if (options->verbose)
+			std::cerr << "[Network Exception]" << what << ": " << ec.message() << std::endl;
+		topic->publish(SigMan::NetStat::NetworkException, ec);
+	}
+	void finish() {
+		result.elapsed = std::chrono::steady_clock::now() - startTime;
+		if (onFinished)
+			onFinished(result);
+		self.reset();
+	}
+	void resolved(ResolveCache::Source source) {
+		result.resolve = std::chrono::steady_clock::now() - startTime;
+		result.dnsSource = source;
+	}
+	void connected(const tcp::endpoint & ep) {
+		result.connect = std::chrono::steady_clock::now() - connectStart;
+		result.peer = ep;
+		this->reach(SigMan::NetStat::Connected);
+	}
+	void handshaked() {
+		result.handshake = std::chrono::steady_clock::now() - handshakeStart;
+		result.resumption = connection->sessionMan.resumption();
+		result.tlsVersion = connection->sessionMan.version();
+		this->reach(SigMan::NetStat::Handshaked);
+	}
+	void prepareRequests() {
+		req.method(options->mode == ProbeMode::Head ? http::verb::head : http::verb::get);
+		req.set(http::field::host, host);
+		pipeline.clear();
+		{
+			auto serialized = beast::ostream(pipeline);
+			for (const auto & target: options->paths) {
+				req.target(target);
+				serialized << req;
+			}
+		}
+		responsesRead = 0;
+		result.paths.clear();
+		requestStart = std::chrono::steady_clock::now();
+		connection->stream.next_layer().expires_after(options->timeout);
+	}
+	void prepareResponse() {
+		parser.emplace();
+		parser->body_limit(std::numeric_limits<std::uint64_t>::max());
+		if (options->mode == ProbeMode::Head)
+			parser->skip(true);
+		bodyBytes = 0;
+		if (digest)
+			digest->clear();
+		responseStart = responsesRead == 0 ? requestStart : std::chrono::steady_clock::now();
+		connection->stream.next_layer().expires_after(options->timeout);
+	}
+	void headerRead() {
+		headerTime = std::chrono::steady_clock::now();
+		if (options->verbose) {
+			std::cout << "------------------------------------------------------------------------" << std::endl;
+			std::cout << parser->get().base() << std::flush;
+		}
+	}
+	bool bodyLimitReached() const {
+		return options->maxBody != 0 && bodyBytes >= options->maxBody;
+	}
+	// Points the parser at bodyBuffer, returns the room offered.
+	std::size_t prepareChunk() {
+		if (!bodyBuffer) {
+			bodyBuffer = std::make_unique_for_overwrite<char[]>(options->bodyBuffer);
+			bodyBufferSize = options->bodyBuffer;
+		}
+		auto & body = parser->get().body();
+		body.data = bodyBuffer.get();
+		body.size = options->maxBody == 0
+			? options->bodyBuffer
+			: static_cast<std::size_t>(std::min<std::uint64_t>(options->bodyBuffer, options->maxBody - bodyBytes));
+		return body.size;
+	}
+	void chunkRead(std::size_t offered) {
+		const std::size_t got = offered - parser->get().body().size;
+		bodyBytes += got;
+		if (digest)
+			digest->update(reinterpret_cast<const std::uint8_t *>(bodyBuffer.get()), got);
+		if (options->verbose)
+			std::cout.write(bodyBuffer.get(), got);
+	}
+	// complete is false when the body was not read to the end; such a
+	// connection can neither carry the next pipelined response nor be
+	// pooled, so the probe ends with it.
+	void recordResponse(bool complete) {
+		const auto & header = parser->get();
+		const auto & target = options->paths[responsesRead++];
+		const auto now = std::chrono::steady_clock::now();
+		result.paths.push_back({
+			target,
+			header.result_int(),
+			now - requestStart,
+			headerTime - responseStart,
+			now - headerTime,
+			bodyBytes,
+			!complete
+		});
+		if (digest) {
+			std::array<std::uint8_t, maxDigestLength> hash;
+			digest->final(hash.data());
+			result.paths.back().digest = Botan::hex_encode(hash.data(), digest->output_length(), false);
+		}
+		if (responsesRead == 1)
+			result.httpStatus = header.result_int();
+		if (options->verbose)
+			std::cout << std::endl;
+	}
+	bool morePipelined(bool complete) const {
+		return complete && responsesRead < options->paths.size();
+	}
+	void completed(bool complete) {
+		result.tlsVersion = connection->sessionMan.version();
+		this->reach(SigMan::NetStat::Got);
+		if (complete && ConnectionPool::enabled() && parser->get().keep_alive() && buffer.size() == 0)
+			connectionPool.checkin(poolKey, std::move(connection));
+	}
+private:
+// The coroutine session: one frame per probe, errors come back as values
+// through redirect_error and end the probe through failed(), nothing is
+// thrown into the io_context.
+	template <typename CompletionToken>
+	auto asyncResolve(CompletionToken && token) {
+		return asio::async_initiate<
+			CompletionToken,
+			void(beast::error_code, ResolveCache::Results, ResolveCache::Source)
+		>(
+			[this] (auto handler) {
+				ResolveCache::instance().resolve(ioContext.get_executor(), host, port, copyableHandler(std::move(handler)));
+			},
+			token
+		);
+	}
+	template <typename CompletionToken>
+	auto asyncHappyEyeballs(const ResolveCache::Results & results, CompletionToken && token) {
+		return asio::async_initiate<
+			CompletionToken,
+			void(beast::error_code, HappyEyeballs::Socket, tcp::endpoint)
+		>(
+			[this, &results] (auto handler) {
+				std::make_shared<HappyEyeballs>(
+					ioContext.get_executor(),
+					results,
+					options->connectAttemptDelay,
+					copyableHandler(std::move(handler))
+				)->start(options->timeout);
+			},
+			token
+		);
+	}
+	template <typename CompletionToken>
+	auto asyncHandshake(CompletionToken && token) {
+		return asio::async_initiate<CompletionToken, void(beast::error_code)>(
+			[this] (auto handler) {
+				connection->stream.async_handshake(TLS::Connection_Side::CLIENT, std::move(handler));
+			},
+			token
+		);
+	}
+	// A retry runs a new probe coroutine, so only that rare path costs a
+	// second frame.
+	void failed(std::shared_ptr<AppSession> keepAlive, beast::error_code ec, const char * what) {
+		if (this->retryOnFreshConnection())
+			return asio::co_spawn(ioContext, this->probe(std::move(keepAlive)), asio::detached);
+		this->recordFailure(ec, what);
+		this->finish();
+	}
+	asio::awaitable<void> probe(std::shared_ptr<AppSession> keepAlive) {
+		beast::error_code ec;
+		auto token = recyclingToken(asio::redirect_error(asio::use_awaitable, ec));
+		if (!connection) {
+			if (!this->createConnection()) {
+				this->finish();
+				co_return;
+			}
+			auto [results, source] = co_await this->asyncResolve(token);
+			this->resolved(source);
+			if (ec)
+				co_return this->failed(std::move(keepAlive), ec, "Resolve Error");
+			this->reach(SigMan::NetStat::Resolved);
+			connectStart = std::chrono::steady_clock::now();
+			tcp::endpoint ep;
+			if (options->connectAttemptDelay.count() > 0) {
+				auto [socket, winner] = co_await this->asyncHappyEyeballs(results, token);
+				if (ec)
+					co_return this->failed(std::move(keepAlive), ec, "Connect Error");
+				connection->stream.next_layer().socket() = std::move(socket);
+				ep = winner;
+			} else {
+				connection->stream.next_layer().expires_after(options->timeout);
+				ep = co_await connection->stream.next_layer().async_connect(results, token);
+				if (ec)
+					co_return this->failed(std::move(keepAlive), ec, "Connect Error");
+			}
+			this->connected(ep);
+			handshakeStart = std::chrono::steady_clock::now();
+			connection->stream.next_layer().expires_after(options->timeout);
+			co_await this->asyncHandshake(token);
+			if (ec)
+				co_return this->failed(std::move(keepAlive), ec, "Handshake Error");
+			this->handshaked();
 		}
+		this->prepareRequests();
+		co_await asio::async_write(connection->stream, pipeline.data(), token);
+		if (ec)
+			co_return this->failed(std::move(keepAlive), ec, "Http Request Error");
+		this->reach(SigMan::NetStat::Requested);
+		bool complete;
+		do {
+			this->prepareResponse();
+			co_await http::async_read_header(connection->stream, buffer, *parser, token);
+			if (ec)
+				co_return this->failed(std::move(keepAlive), ec, "Read Web Content Error");
+			this->headerRead();
+			complete = options->mode != ProbeMode::Headers;
+			while (complete && !parser->is_done()) {
+				if (this->bodyLimitReached()) {
+					complete = false;
+					break;
+				}
+				const std::size_t offered = this->prepareChunk();
+				co_await http::async_read_some(connection->stream, buffer, *parser, token);
+				if (ec == http::error::need_buffer)
+					ec = {};
+				if (ec)
+					co_return this->failed(std::move(keepAlive), ec, "Read Web Content Error");
+				this->chunkRead(offered);
+			}
+			this->recordResponse(complete);
+			if (this->morePipelined(complete) && !parser->get().keep_alive())
+				co_return this->failed(std::move(keepAlive), asio::error::eof, "Server Closed Pipeline");
+		} while (this->morePipelined(complete));
+		this->completed(complete);
+		this->finish();
+	}
+private:
+// The callback chain. Completion handlers must not throw: the io_context
+// can be shared by many sessions, and an exception would unwind all of
+// them.
+	void connectFresh() {
+		if (!this->createConnection())
+			return this->finish();
+		this->resolve();
+	}
+	void fail(beast::error_code ec, const char * what) {
+		if (this->retryOnFreshConnection())
+			return this->connectFresh();
+		this->recordFailure(ec, what);
+		this->finish();
 	}
 	void resolve() {
-		resolver.async_resolve(
+		ResolveCache::instance().resolve(
+			ioContext.get_executor(),
 			host,
 			port,
 			[self=self] (
 				beast::error_code ec,
-				tcp::resolver::results_type results
+				tcp::resolver::results_type results,
+				ResolveCache::Source source
 			) {
+				self->resolved(source);
 				if (ec)
-					throw std::system_error{ec, "Resolve Error"};
-				self->circleSigMan.update(SigMan::NetStat::Resolved);
+					return self->fail(ec, "Resolve Error");
+				self->reach(SigMan::NetStat::Resolved);
 				self->connect(std::move(results));
 			}
 		);
 	}
 	void connect(tcp::resolver::results_type && results) {
-		tlsStream.next_layer().expires_after(std::chrono::seconds(12));
-		tlsStream.next_layer().async_connect(
+		connectStart = std::chrono::steady_clock::now();
+		if (options->connectAttemptDelay.count() > 0) {
+			std::make_shared<HappyEyeballs>(
+				ioContext.get_executor(),
+				results,
+				options->connectAttemptDelay,
+				[self=self] (
+					beast::error_code ec,
+					HappyEyeballs::Socket && socket,
+					tcp::endpoint ep
+				) {
+					if (ec)
+						return self->fail(ec, "Connect Error");
+					self->connection->stream.next_layer().socket() = std::move(socket);
+					self->connected(ep);
+					self->handshake();
+				}
+			)->start(options->timeout);
+			return;
+		}
+		connection->stream.next_layer().expires_after(options->timeout);
+		connection->stream.next_layer().async_connect(
 			results,
-			[self=self] (
+			recycled([self=self] (
 				beast::error_code ec,
 				tcp::endpoint ep
 			) {
 				if (ec)
-					throw std::system_error{ec, "Connect Error"};
-				self->circleSigMan.update(SigMan::NetStat::Connected);
+					return self->fail(ec, "Connect Error");
+				self->connected(ep);
 				self->handshake();
-			}
+			})
 		);
 	}
 	void handshake() {
-		tlsStream.next_layer().expires_after(std::chrono::seconds(12));
-		tlsStream.async_handshake(
+		handshakeStart = std::chrono::steady_clock::now();
+		connection->stream.next_layer().expires_after(options->timeout);
+		connection->stream.async_handshake(
 			TLS::Connection_Side::CLIENT,
-			[self=self] (
+			recycled([self=self] (
 				beast::error_code ec
 			) {
 				if (ec)
-					throw std::system_error{ec, "Handshake Error"};
-				self->circleSigMan.update(SigMan::NetStat::Handshaked);
+					return self->fail(ec, "Handshake Error");
+				self->handshaked();
 				self->write();
-			}
+			})
 		);
 	}
 	void write() {
-		req.method(http::verb::get);
-		req.version(11);
-		req.target("/");
-		req.set(http::field::host, host);
-		req.set(http::field::user_agent, "Botan::TLS-boost::beast-Session-"s + BOOST_BEAST_VERSION_STRING);
-		tlsStream.next_layer().expires_after(std::chrono::seconds(12));
-		http::async_write(
-			tlsStream,
-			req,
-			[self=self] (
+		this->prepareRequests();
+		asio::async_write(
+			connection->stream,
+			pipeline.data(),
+			recycled([self=self] (
 				beast::error_code ec,
-				std::size_t size
+				std::size_t
 			) {
 				if (ec)
-					throw std::system_error{ec, "Http Request Error"};
-				self->circleSigMan.update(SigMan::NetStat::Requested);
+					return self->fail(ec, "Http Request Error");
+				self->reach(SigMan::NetStat::Requested);
 				self->read();
-			}
+			})
 		);
 	}
+	// The header is read first, so time to first byte and body transfer
+	// can be told apart.
 	void read() {
-		tlsStream.next_layer().expires_after(std::chrono::seconds(12));
-		http::async_read(
-			tlsStream,
+		this->prepareResponse();
+		http::async_read_header(
+			connection->stream,
 			buffer,
-			res,
-			[self=self] (
+			*parser,
+			recycled([self=self] (
 				beast::error_code ec,
-				std::size_t size
+				std::size_t
 			) {
 				if (ec)
-					throw std::system_error{ec, "Read Web Content Error"};
-				self->circleSigMan.update(SigMan::NetStat::Got);
-				std::cout << "------------------------------------------------------------------------" << std::endl;
-				std::cout << self->res << std::endl;
-			}
+					return self->fail(ec, "Read Web Content Error");
+				self->headerRead();
+				if (self->options->mode == ProbeMode::Headers)
+					return self->gotResponse(false);
+				self->readBody();
+			})
+		);
+	}
+	// Streams the body through bodyBuffer, one read at a time, so nothing
+	// grows with the response size.
+	void readBody() {
+		if (parser->is_done())
+			return this->gotResponse(true);
+		if (this->bodyLimitReached())
+			return this->gotResponse(false);
+		const std::size_t offered = this->prepareChunk();
+		http::async_read_some(
+			connection->stream,
+			buffer,
+			*parser,
+			recycled([self=self, offered] (
+				beast::error_code ec,
+				std::size_t
+			) {
+				if (ec == http::error::need_buffer)
+					ec = {};
+				if (ec)
+					return self->fail(ec, "Read Web Content Error");
+				self->chunkRead(offered);
+				self->readBody();
+			})
 		);
 	}
+	void gotResponse(bool complete) {
+		this->recordResponse(complete);
+		if (this->morePipelined(complete)) {
+			if (!parser->get().keep_alive())
+				return this->fail(asio::error::eof, "Server Closed Pipeline");
+			return this->read();
+		}
+		this->completed(complete);
+		this->finish();
+	}
+};
+
+// Finished AppSessions of one io_context, kept for the next probe and
+// reached through asio::use_service. Like the ConnectionPool only the
+// thread running that io_context touches it, so sessions are acquired in a
+// handler posted there and are handed back by the last shared_ptr, which
+// the session's own handlers hold. A session released anywhere else (the
+// io_context being destroyed) is simply deleted.
+class SessionPool: public asio::execution_context::service {
+private:
+	struct Recycler {
+		SessionPool * pool;
+		void operator()(AppSession * session) const noexcept {
+			pool->recycle(session);
+		}
+	};
+	asio::io_context & ioContext;
+	std::vector<std::unique_ptr<AppSession>> idle;
+	std::size_t inUse = 0;
+	bool closed = false;
+	static inline std::atomic<std::size_t> createdCount = 0;
+	static inline std::atomic<std::size_t> highWaterMark = 0; // Most in use on one io_context
+public:
+	inline static asio::execution_context::id id;
+	explicit SessionPool(asio::io_context & _ioContext_)
+	:
+		asio::execution_context::service{_ioContext_},
+		ioContext{_ioContext_}
+	{
+	}
+	// Same arguments as AppSession::reset(). A session that fails to reset
+	// stays in the pool.
+	template <typename... Args>
+	std::shared_ptr<AppSession> acquire(Args && ... args) {
+		std::unique_ptr<AppSession> session;
+		if (idle.empty()) {
+			session = std::make_unique<AppSession>(ioContext);
+			++createdCount;
+		} else {
+			session = std::move(idle.back());
+			idle.pop_back();
+		}
+		try {
+			session->reset(std::forward<Args>(args)...);
+		} catch (...) {
+			idle.push_back(std::move(session));
+			throw;
+		}
+		const std::size_t now = ++inUse;
+		std::size_t mark = highWaterMark;
+		while (now > mark && !highWaterMark.compare_exchange_weak(mark, now))
+			;
+		return {session.release(), Recycler{this}, RecyclingAllocator<AppSession>{}};
+	}
+	static std::size_t created() {
+		return createdCount;
+	}
+	static std::size_t highWater() {
+		return highWaterMark;
+	}
+private:
+	void recycle(AppSession * session) noexcept {
+		if (closed || !ioContext.get_executor().running_in_this_thread()) {
+			delete session;
+			return;
+		}
+		--inUse;
+		session->release();
+		idle.emplace_back(session);
+	}
+	void shutdown() override {
+		closed = true;
+		idle.clear();
+	}
 };
 
+// The one way a session is started, for the window, --batch and --every.
+// The slot is chosen on the calling thread, the session is taken from the
+// SessionPool of its io_context on that io_context's thread. report gets the
+// result on that thread, a setup error result included, so every launch is
+// reported exactly once. target must stay valid until report is called.
+template <typename Report>
+void launchSession(
+	IoContextPool & ioPool,
+	const ProbeTarget & target,
+	std::shared_ptr<SigMan::Topic> topic,
+	std::shared_ptr<const ProbeOptions> options,
+	Report report // void (const ProbeResult &)
+) {
+	IoContextPool::Slot & slot = ConnectionPool::enabled()
+		? ioPool.acquireFor(target.host + ':' + target.port)
+		: ioPool.acquire();
+	asio::post(slot.context(), recycled([
+		&slot,
+		&target,
+		topic=std::move(topic),
+		options=std::move(options),
+		report=std::move(report)
+	] () mutable {
+		try {
+			asio::use_service<SessionPool>(slot.context()).acquire(
+				target.host,
+				target.port,
+				topic,
+				std::move(options),
+				[&slot, report] (const ProbeResult & result) {
+					slot.release();
+					report(result);
+				}
+			)->start();
+		} catch (std::exception & exc) {
+			ProbeResult result;
+			result.host = target.host;
+			result.port = target.port;
+			result.failed = true;
+			result.what = "Session Setup Error: "s + exc.what();
+			result.stat = SigMan::NetStat::CppGeneralException;
+			slot.release();
+			topic->publish(result.stat);
+			report(result);
+		}
+	}));
+}
+
 auto startSession = [] (
+	IoContextPool & ioPool,
 	const std::string & host,
 	const std::string & port,
-	SigMan & sigMan
+	const std::shared_ptr<SigMan::Topic> & topic,
+	const std::shared_ptr<const ProbeOptions> & options,
+	const AppSession::FinishHandler & report // Called on the session's io thread
 ) {
 	try {
-		sigMan.update(SigMan::NetStat::ProgramStarted);
+		topic->publish(SigMan::NetStat::ProgramStarted);
 
 		std::cout << "Hello, Cpp! The c++ programming language." << std::endl;
-		auto appSession = std::make_shared<AppSession>(host, port, sigMan);
-
-		appSession->start();
+		// Owned by the report handler, so it outlives the session start.
+		auto target = std::make_shared<const ProbeTarget>(ProbeTarget{host, port});
+		launchSession(ioPool, *target, topic, options, [target, report] (const ProbeResult & result) {
+			report(result);
+			std::cout << "************************************************************************\n";
+			std::cout << "Network Session Closed!\n" << result << '\n';
+		});
 	} catch (std::exception & exc) {
-		sigMan.update(SigMan::NetStat::CppGeneralException);
+		topic->publish(SigMan::NetStat::CppGeneralException);
 		std::cerr << "[Cpp General Exception]" << exc.what() << std::endl;
 	}
 };
 
-auto startMainWindow = [] (irr::video::E_DRIVER_TYPE driverType, SigMan & sigMan) {
+auto startMainWindow = [] (
+	irr::video::E_DRIVER_TYPE driverType,
+	SigMan & sigMan,
+	IoContextPool & ioPool,
+	std::shared_ptr<const ProbeOptions> probeOptions
+) {
 	try {
-		MainWindow mainWindow{1234, 694, driverType, sigMan};
+		MainWindow mainWindow{1234, 694, driverType, sigMan, ioPool, std::move(probeOptions)};
 		mainWindow.open();
 	} catch (std::exception & exc) {
 		std::cerr << "[Irrlicht Exception]" << std::endl;
 	}
 };
 
+// Called by the window loop thread. The session runs on the shared io_context
+// pool and shows up as a tile of the dashboard, so nothing here blocks.
 void MainWindow::newSession(const std::string & host, const std::string & port) {
-	OpenWindow openWindow{this->sigMan};
+	auto topic = sigMan.createTopic();
+	dashboard.addSession(topic->id(), host + ':' + port);
 	std::cout << "A new session is started!\n";
-	auto sessionThread = std::async(
-		std::launch::async,
-		startSession,
+	startSession(
+		this->ioPool,
 		host,
 		port,
-		std::ref(this->sigMan)
+		topic,
+		probeOptions,
+		[results=results.sink(), latencies=latencies.sink()] (const ProbeResult & result) {
+			auto row = ResultStore::Row::of(result);
+			latencies->push({
+				row.ms[ResultStore::Dns],
+				row.ms[ResultStore::Connect],
+				row.ms[ResultStore::Tls],
+				row.ms[ResultStore::Ttfb]
+			});
+			results->add(std::move(row));
+		}
 	);
 }
 
-int main() try {
+// One parseTarget() entry per line, 443 when no port is given. Empty lines
+// and lines starting with '#' are skipped.
+std::vector<ProbeTarget> readTargets(std::istream & in) {
+	std::vector<ProbeTarget> targets;
+	std::string line;
+	while (std::getline(in, line)) {
+		const auto first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos || line[first] == '#')
+			continue;
+		const auto last = line.find_last_not_of(" \t\r");
+		targets.push_back(parseTarget(std::string_view{line.data() + first, last - first + 1}, "443"));
+	}
+	return targets;
+}
+
+// Runs many AppSessions on an IoContextPool without any window. At most
+// `concurrency` sessions are in flight; each finished session starts the
+// next target and prints one result line.
+class BatchProbe {
+private:
+	IoContextPool & ioPool;
+	SigMan & sigMan;
+	const std::vector<ProbeTarget> & targets;
+	const std::size_t concurrency;
+	const std::size_t total; // targets.size() times the number of rounds
+	const std::shared_ptr<const ProbeOptions> options; // Shared by every session
+	std::mutex mutex;
+	std::condition_variable allDone;
+	std::size_t nextTarget = 0;
+	std::size_t running = 0;
+	std::size_t failed = 0;
+	std::size_t reused = 0;
+	PhaseHistograms<7> aggregate;
+	// Lower precision per target keeps 100k targets affordable.
+	std::unique_ptr<PhaseHistograms<4>[]> perTarget;
+public:
+	BatchProbe(
+		IoContextPool & ioPool,
+		SigMan & sigMan,
+		const std::vector<ProbeTarget> & targets,
+		std::size_t concurrency,
+		std::size_t rounds,
+		bool perTargetStats,
+		const ProbeOptions & options
+	)
+	:
+		ioPool{ioPool},
+		sigMan{sigMan},
+		targets{targets},
+		concurrency{concurrency > 0 ? concurrency : 1},
+		total{targets.size() * rounds},
+		options{std::make_shared<const ProbeOptions>(options)}
+	{
+		if (perTargetStats)
+			perTarget = std::make_unique<PhaseHistograms<4>[]>(targets.size());
+	}
+	void start() {
+		this->launchMore();
+	}
+	void wait() {
+		std::unique_lock lock{mutex};
+		allDone.wait(lock, [this] { return running == 0 && nextTarget == total; });
+	}
+	std::size_t failedCount() {
+		std::lock_guard lock{mutex};
+		return failed;
+	}
+	std::size_t reusedCount() {
+		std::lock_guard lock{mutex};
+		return reused;
+	}
+	void printLatency(std::ostream & out) const {
+		out << "Latency of all targets:\n";
+		aggregate.print(out, "  ");
+		if (!perTarget)
+			return;
+		for (std::size_t i=0; i<targets.size(); ++i) {
+			out << targets[i].host << ':' << targets[i].port << '\n';
+			perTarget[i].print(out, "  ");
+		}
+	}
+private:
+	void launchMore() {
+		for (;;) {
+			std::size_t index;
+			{
+				std::lock_guard lock{mutex};
+				if (running >= concurrency || nextTarget >= total)
+					break;
+				index = nextTarget++ % targets.size();
+				++running;
+			}
+			this->launch(index);
+		}
+	}
+	void launch(std::size_t index) {
+		launchSession(ioPool, targets[index], sigMan.createTopic(), options, [this, index] (const ProbeResult & result) {
+			this->finished(index, result);
+		});
+	}
+	void finished(std::size_t index, const ProbeResult & result) {
+		aggregate.record(result);
+		if (perTarget)
+			perTarget[index].record(result);
+		{
+			std::lock_guard lock{mutex};
+			--running;
+			if (result.failed)
+				++failed;
+			if (result.reused)
+				++reused;
+			std::cout << result << '\n';
+			if (running == 0 && nextTarget == total) {
+				std::cout.flush();
+				allDone.notify_all();
+				return;
+			}
+		}
+		this->launchMore();
+	}
+};
+
+// Probes every target again and again, every `interval` give or take
+// `jitter` of it, until stopped (--every). Due times live in a hashed timer
+// wheel driven by one steady_timer on one io_context: a bucket per tick,
+// each an intrusive list threaded through the entries, so scheduling and
+// cancelling a target cost O(1) and a tick only visits its own bucket,
+// however many targets there are. Targets due after more than one turn of
+// the wheel count down their remaining turns. A target whose last probe is
+// still running (or still waiting for a free place) when it is due again
+// skips that round; beyond `concurrency` probes in flight, due targets wait
+// in a FIFO.
+class ProbeScheduler {
+public:
+	static constexpr std::chrono::milliseconds tick{20};
+	static constexpr std::uint32_t wheelSize = 4096; // About 82 seconds per turn
+private:
+	static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+	enum class State: std::uint8_t {
+		Idle,
+		Waiting,
+		Running
+	};
+	struct Entry {
+		std::uint32_t prev = none;
+		std::uint32_t next = none;
+		std::uint32_t slot = none; // none while not in the wheel
+		std::uint32_t turns = 0; // Full turns of the wheel left before it is due
+		std::chrono::steady_clock::time_point due;
+		State state = State::Idle;
+	};
+	IoContextPool & ioPool;
+	SigMan & sigMan;
+	const std::vector<ProbeTarget> & targets;
+	const std::chrono::steady_clock::duration interval;
+	const double jitter;
+	const std::size_t concurrency;
+	const std::shared_ptr<const ProbeOptions> options; // Shared by every session
+	// The wheel and everything below up to the counters is only touched on
+	// this io_context's thread.
+	asio::io_context & context;
+	asio::steady_timer timer;
+	asio::steady_timer deadline;
+	asio::signal_set signals;
+	std::vector<Entry> entries; // One per target
+	std::array<std::uint32_t, wheelSize> buckets;
+	std::deque<std::uint32_t> waiting;
+	std::chrono::steady_clock::time_point epoch; // Time of tick 0
+	std::uint64_t nextTick = 0; // Absolute number of the next tick to run
+	std::size_t running = 0;
+	bool stopping = false;
+	std::minstd_rand random{std::random_device{}()};
+	// Counted on the io threads.
+	std::atomic<std::uint64_t> probed = 0;
+	std::atomic<std::uint64_t> failed = 0;
+	std::atomic<std::uint64_t> skipped = 0;
+	PhaseHistograms<7> aggregate;
+	std::mutex outputMutex;
+	std::mutex doneMutex;
+	std::condition_variable allDone;
+	bool done = false;
+public:
+	ProbeScheduler(
+		IoContextPool & ioPool,
+		SigMan & sigMan,
+		const std::vector<ProbeTarget> & targets,
+		std::chrono::steady_clock::duration interval,
+		double jitter,
+		std::size_t concurrency,
+		const ProbeOptions & options
+	)
+	:
+		ioPool{ioPool},
+		sigMan{sigMan},
+		targets{targets},
+		interval{std::max<std::chrono::steady_clock::duration>(interval, tick)},
+		jitter{std::clamp(jitter, 0.0, 1.0)},
+		concurrency{concurrency > 0 ? concurrency : 1},
+		options{std::make_shared<const ProbeOptions>(options)},
+		context{ioPool.context(0)},
+		timer{context},
+		deadline{context},
+		signals{context, SIGINT, SIGTERM},
+		entries(targets.size())
+	{
+		if (targets.size() >= none)
+			throw std::runtime_error{"Too many targets for the scheduler"};
+		buckets.fill(none);
+	}
+	// Spreads the first probes evenly over one interval, then keeps going
+	// until SIGINT/SIGTERM or, when duration is not zero, until it is over.
+	void start(std::chrono::steady_clock::duration duration) {
+		asio::post(context, [this, duration] {
+			epoch = std::chrono::steady_clock::now();
+			std::uniform_real_distribution<double> offset{0, 1};
+			for (std::uint32_t i=0; i<entries.size(); ++i)
+				this->schedule(
+					i,
+					epoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * offset(random))
+				);
+			signals.async_wait([this] (beast::error_code ec, int) {
+				if (!ec)
+					this->stop();
+			});
+			if (duration.count() > 0) {
+				deadline.expires_after(duration);
+				deadline.async_wait([this] (beast::error_code ec) {
+					if (!ec)
+						this->stop();
+				});
+			}
+			this->arm();
+		});
+	}
+	// Returns once stopped and every probe in flight has finished.
+	void wait() {
+		std::unique_lock lock{doneMutex};
+		allDone.wait(lock, [this] { return done; });
+	}
+	std::uint64_t probeCount() const {
+		return probed;
+	}
+	std::uint64_t failedCount() const {
+		return failed;
+	}
+	std::uint64_t skippedCount() const {
+		return skipped;
+	}
+	void printLatency(std::ostream & out) const {
+		out << "Latency of all targets:\n";
+		aggregate.print(out, "  ");
+	}
+private:
+	void schedule(std::uint32_t index, std::chrono::steady_clock::time_point due) {
+		this->cancel(index);
+		Entry & entry = entries[index];
+		entry.due = due;
+		// The tick at or after due, but never one that already ran.
+		const auto ticks = (due - epoch + tick - std::chrono::steady_clock::duration{1}) / tick;
+		const std::uint64_t at = std::max<std::uint64_t>(nextTick, ticks > 0 ? ticks : 0);
+		entry.slot = static_cast<std::uint32_t>(at % wheelSize);
+		entry.turns = static_cast<std::uint32_t>((at - nextTick) / wheelSize);
+		entry.prev = none;
+		entry.next = buckets[entry.slot];
+		if (entry.next != none)
+			entries[entry.next].prev = index;
+		buckets[entry.slot] = index;
+	}
+	void cancel(std::uint32_t index) {
+		Entry & entry = entries[index];
+		if (entry.slot == none)
+			return;
+		if (entry.prev != none)
+			entries[entry.prev].next = entry.next;
+		else
+			buckets[entry.slot] = entry.next;
+		if (entry.next != none)
+			entries[entry.next].prev = entry.prev;
+		entry.slot = entry.prev = entry.next = none;
+	}
+	void arm() {
+		timer.expires_at(epoch + nextTick * tick);
+		timer.async_wait([this] (beast::error_code ec) {
+			if (ec || stopping)
+				return;
+			this->advance();
+			this->arm();
+		});
+	}
+	// Runs every tick whose time has come, late ones included.
+	void advance() {
+		const auto now = std::chrono::steady_clock::now();
+		while (epoch + nextTick * tick <= now) {
+			std::uint32_t index = buckets[nextTick % wheelSize];
+			++nextTick;
+			while (index != none) {
+				Entry & entry = entries[index];
+				const std::uint32_t following = entry.next;
+				if (entry.turns > 0) {
+					--entry.turns;
+				} else {
+					this->cancel(index);
+					this->due(index);
+				}
+				index = following;
+			}
+		}
+	}
+	void due(std::uint32_t index) {
+		Entry & entry = entries[index];
+		const double factor = 1 + jitter * std::uniform_real_distribution<double>{-1, 1}(random);
+		this->schedule(index, entry.due + std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval * factor));
+		if (entry.state != State::Idle) {
+			++skipped;
+			return;
+		}
+		if (running >= concurrency) {
+			entry.state = State::Waiting;
+			waiting.push_back(index);
+			return;
+		}
+		this->launch(index);
+	}
+	// The result comes back here through report().
+	void launch(std::uint32_t index) {
+		entries[index].state = State::Running;
+		++running;
+		launchSession(ioPool, targets[index], sigMan.createTopic(), options, [this, index] (const ProbeResult & result) {
+			this->report(index, result);
+		});
+	}
+	// On the session's io thread.
+	void report(std::uint32_t index, const ProbeResult & result) {
+		aggregate.record(result);
+		++probed;
+		if (result.failed)
+			++failed;
+		{
+			std::lock_guard lock{outputMutex};
+			std::cout << result << '\n';
+		}
+		asio::post(context, [this, index] { this->finished(index); });
+	}
+	void finished(std::uint32_t index) {
+		entries[index].state = State::Idle;
+		--running;
+		while (!stopping && running < concurrency && !waiting.empty()) {
+			const std::uint32_t next = waiting.front();
+			waiting.pop_front();
+			this->launch(next);
+		}
+		this->finishIfIdle();
+	}
+	void stop() {
+		if (std::exchange(stopping, true))
+			return;
+		timer.cancel();
+		deadline.cancel();
+		beast::error_code ignored;
+		signals.clear(ignored); // A second Ctrl-C ends the program at once
+		signals.cancel();
+		for (const std::uint32_t index: waiting)
+			entries[index].state = State::Idle;
+		waiting.clear();
+		this->finishIfIdle();
+	}
+	void finishIfIdle() {
+		if (!stopping || running != 0)
+			return;
+		std::cout.flush();
+		std::lock_guard lock{doneMutex};
+		done = true;
+		allDone.notify_all();
+	}
+};
+
+// Loopback benchmark of the TLS profiles, run by --tls-bench. A Botan TLS
+// server with a throw-away ECDSA P-256 certificate listens on 127.0.0.1,
+// and every profile does full handshakes against it, one after another,
+// on one io_context thread. Both ends run in this process, so the CPU time
+// per handshake is that of client and server together.
+class HandshakeBench {
+public:
+	struct Result {
+		std::size_t handshakes = 0;
+		std::size_t failed = 0;
+		std::chrono::duration<double> elapsed{};
+		std::chrono::duration<double> cpu{};
+	};
+private:
+	// Presents the certificate as the server and trusts it as the client.
+	class Credentials: public Botan::Credentials_Manager {
+	private:
+		Botan::Private_Key & key;
+		const Botan::X509_Certificate certificate;
+		Botan::Certificate_Store_In_Memory store;
+	public:
+		Credentials(Botan::Private_Key & _key_, Botan::RandomNumberGenerator & rng)
+		:
+			key{_key_},
+			certificate{selfSigned(_key_, rng)}
+		{
+			store.add_certificate(certificate);
+		}
+		std::vector<Botan::Certificate_Store *> trusted_certificate_authorities(
+			const std::string &,
+			const std::string &
+		) override {
+			return {&store};
+		}
+		std::vector<Botan::X509_Certificate> cert_chain(
+			const std::vector<std::string> & keyTypes,
+			const std::string & type,
+			const std::string &
+		) override {
+			if (type != "tls-server" || std::find(keyTypes.begin(), keyTypes.end(), "ECDSA") == keyTypes.end())
+				return {};
+			return {certificate};
+		}
+		Botan::Private_Key * private_key_for(
+			const Botan::X509_Certificate &,
+			const std::string &,
+			const std::string &
+		) override {
+			return &key;
+		}
+	private:
+		static Botan::X509_Certificate selfSigned(const Botan::Private_Key & key, Botan::RandomNumberGenerator & rng) {
+			Botan::X509_Cert_Options options{"localhost"};
+			options.dns = "localhost";
+			return Botan::X509::create_self_signed_cert(options, key, "SHA-256", rng);
+		}
+	};
+	asio::io_context ioContext{1};
+	tcp::acceptor acceptor{ioContext, tcp::endpoint{asio::ip::make_address("127.0.0.1"), 0}};
+	Botan::AutoSeeded_RNG rng;
+	Botan::ECDSA_PrivateKey key{rng, Botan::EC_Group{"secp256r1"}};
+	Credentials credentials{key, rng};
+	TLS::Session_Manager_Noop noSessions; // Every handshake is a full one
+	TLS::Policy serverPolicy;
+	TLS::Context serverContext{credentials, rng, noSessions, serverPolicy};
+	TLS::Context * clientContext = nullptr;
+	std::size_t remaining = 0;
+	Result current;
+public:
+	HandshakeBench() {
+		this->accept();
+	}
+	Result run(TlsEssentials::Profile profile, std::size_t count) {
+		const std::unique_ptr<TLS::Policy> policy = TlsEssentials::makePolicy(profile);
+		TLS::Context context{
+			credentials,
+			rng,
+			noSessions,
+			*policy,
+			TLS::Server_Information{"localhost", acceptor.local_endpoint().port()}
+		};
+		clientContext = &context;
+		remaining = count;
+		current = {};
+		const auto begin = std::chrono::steady_clock::now();
+		const std::clock_t cpuBegin = std::clock();
+		this->handshake();
+		while (current.handshakes + current.failed < count)
+			ioContext.run_one();
+		current.cpu = std::chrono::duration<double>{static_cast<double>(std::clock() - cpuBegin) / CLOCKS_PER_SEC};
+		current.elapsed = std::chrono::steady_clock::now() - begin;
+		clientContext = nullptr;
+		return current;
+	}
+private:
+	void accept() {
+		acceptor.async_accept(
+			[this] (
+				beast::error_code ec,
+				tcp::socket socket
+			) {
+				if (ec)
+					return;
+				auto stream = std::make_shared<TLS::Stream<tcp::socket>>(serverContext, std::move(socket));
+				stream->async_handshake(
+					TLS::Connection_Side::SERVER,
+					[stream] (
+						beast::error_code
+					) {
+					}
+				);
+				this->accept();
+			}
+		);
+	}
+	void handshake() {
+		if (remaining == 0)
+			return;
+		--remaining;
+		auto stream = std::make_shared<TLS::Stream<tcp::socket>>(*clientContext, ioContext);
+		stream->next_layer().async_connect(
+			acceptor.local_endpoint(),
+			[this, stream] (
+				beast::error_code ec
+			) {
+				if (ec) {
+					++current.failed;
+					return this->handshake();
+				}
+				stream->async_handshake(
+					TLS::Connection_Side::CLIENT,
+					[this, stream] (
+						beast::error_code ec
+					) {
+						if (ec)
+							++current.failed;
+						else
+							++current.handshakes;
+						this->handshake();
+					}
+				);
+			}
+		);
+	}
+};
+
+struct CommandLine {
+	std::string batchFile;
+	std::vector<ProbeTarget> targets; // From --target, probed instead of a file
+	std::vector<std::string> caFiles;
+	std::size_t concurrency = 256;
+	std::size_t rounds = 1;
+	bool perTargetStats = false;
+	std::chrono::milliseconds every{0}; // Not zero: probe the targets periodically
+	double jitter = 0.1;
+	std::chrono::seconds duration{0};
+	std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+	std::size_t sessionCache = 10000;
+	bool prewarmTrustStore = false;
+	std::size_t chainCache = 4096;
+	std::chrono::seconds chainCacheTtl{300};
+	std::chrono::seconds dnsTtl{60};
+	std::chrono::seconds dnsNegativeTtl{10};
+	bool nativeDns = false;
+	std::vector<asio::ip::udp::endpoint> nameservers;
+	int dnsAttempts = 2;
+	std::chrono::milliseconds dnsTimeout{1500};
+	std::size_t keepAlive = 0;
+	std::chrono::seconds idleTimeout{30};
+	bool allocStats = false;
+	TlsEssentials::Profile tlsProfile = TlsEssentials::Profile::Compatible;
+	std::size_t tlsBench = 0;
+	unsigned maxFps = 30;
+	std::chrono::milliseconds idleSleep{20};
+	std::string mediaDir; // Empty: embedded media only
+	ProbeOptions probeOptions;
+
+	CommandLine(int argc, char * argv[]) {
+		bool pathsGiven = false;
+		for (int i=1; i<argc; ++i) {
+			const std::string_view arg{argv[i]};
+			auto value = [&] () -> std::string {
+				if (i+1 >= argc)
+					throw std::runtime_error{"Missing value for "s + argv[i]};
+				return argv[++i];
+			};
+			if (arg == "--batch")
+				batchFile = value();
+			else if (arg == "--target") {
+				std::istringstream line{value()};
+				for (auto & target: readTargets(line))
+					targets.push_back(std::move(target));
+			} else if (arg == "--ca-file")
+				caFiles.push_back(value());
+			else if (arg == "--concurrency")
+				concurrency = std::stoul(value());
+			else if (arg == "--rounds")
+				rounds = std::stoul(value());
+			else if (arg == "--per-target")
+				perTargetStats = true;
+			else if (arg == "--every")
+				every = std::chrono::milliseconds{std::llround(std::stod(value()) * 1000)};
+			else if (arg == "--jitter")
+				jitter = std::stod(value());
+			else if (arg == "--duration")
+				duration = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--keep-alive")
+				keepAlive = std::stoul(value());
+			else if (arg == "--idle-timeout")
+				idleTimeout = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--path") {
+				if (!pathsGiven)
+					probeOptions.paths.clear();
+				pathsGiven = true;
+				probeOptions.paths.push_back(value());
+			} else if (arg == "--threads")
+				threads = std::stoul(value());
+			else if (arg == "--session-cache")
+				sessionCache = std::stoul(value());
+			else if (arg == "--prewarm-trust-store")
+				prewarmTrustStore = true;
+			else if (arg == "--chain-cache")
+				chainCache = std::stoul(value());
+			else if (arg == "--chain-cache-ttl")
+				chainCacheTtl = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--dns-ttl")
+				dnsTtl = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--dns-negative-ttl")
+				dnsNegativeTtl = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--native-dns")
+				nativeDns = true;
+			else if (arg == "--nameserver") {
+				nativeDns = true;
+				nameservers.push_back(DnsResolver::parseNameserver(value()));
+			} else if (arg == "--dns-attempts")
+				dnsAttempts = std::stoi(value());
+			else if (arg == "--dns-timeout")
+				dnsTimeout = std::chrono::milliseconds{std::stol(value())};
+			else if (arg == "--connect-delay")
+				probeOptions.connectAttemptDelay = std::chrono::milliseconds{std::stol(value())};
+			else if (arg == "--mode") {
+				const std::string mode = value();
+				if (mode == "body")
+					probeOptions.mode = ProbeMode::Body;
+				else if (mode == "head")
+					probeOptions.mode = ProbeMode::Head;
+				else if (mode == "headers")
+					probeOptions.mode = ProbeMode::Headers;
+				else
+					throw std::runtime_error{"Unknown probe mode: " + mode};
+			} else if (arg == "--max-body")
+				probeOptions.maxBody = std::stoull(value());
+			else if (arg == "--digest") {
+				probeOptions.digest = value();
+				if (!Botan::HashFunction::create(probeOptions.digest))
+					throw std::runtime_error{"Unknown digest: " + probeOptions.digest};
+			} else if (arg == "--body-buffer")
+				probeOptions.bodyBuffer = std::max<std::size_t>(std::stoul(value()), 512);
+			else if (arg == "--coroutines")
+				probeOptions.coroutine = true;
+			else if (arg == "--alloc-stats")
+				allocStats = true;
+			else if (arg == "--tls-profile")
+				tlsProfile = TlsEssentials::parseProfile(value());
+			else if (arg == "--tls-bench")
+				tlsBench = std::stoul(value());
+			else if (arg == "--media")
+				mediaDir = value();
+			else if (arg == "--max-fps")
+				maxFps = std::stoul(value());
+			else if (arg == "--idle-sleep")
+				idleSleep = std::chrono::milliseconds{std::stol(value())};
+			else if (arg == "--timeout")
+				probeOptions.timeout = std::chrono::seconds{std::stol(value())};
+			else if (arg == "--help" || arg == "-h")
+				throw std::runtime_error{usage()};
+			else
+				throw std::runtime_error{"Unknown option: "s + argv[i] + "\n" + usage()};
+		}
+	}
+	static std::string usage() {
+		return
+			"Usage: micburs [options]\n"
+			"  Without --batch the Irrlicht main window is opened.\n"
+			"  --batch FILE      Probe every host:port line of FILE (- for stdin) without gui\n"
+			"  --target HOST:PORT  Probe this target without gui, may be repeated\n"
+			"  --ca-file FILE    Also trust the CA certificate in FILE, may be repeated\n"
+			"  --concurrency N   Maximum sessions in flight in batch mode (default 256)\n"
+			"  --rounds N        Probe the whole target list N times (default 1)\n"
+			"  --every SECONDS   Probe every target again every SECONDS until stopped\n"
+			"                    by Ctrl-C or --duration, instead of --rounds\n"
+			"  --jitter FRACTION Spread each --every period by up to this much (default 0.1)\n"
+			"  --duration SECONDS  Stop --every after SECONDS (default 0, run until stopped)\n"
+			"  --per-target      Also print latency percentiles of every target\n"
+			"  --keep-alive N    Keep up to N idle connections per host and thread for reuse\n"
+			"                    (default 0)\n"
+			"  --path TARGET     Request target, repeat to pipeline several (default /)\n"
+			"  --idle-timeout SECONDS  Drop pooled connections idle this long (default 30)\n"
+			"  --mode MODE       body: GET and stream the body (default), head: HEAD request,\n"
+			"                    headers: GET, stop after the first header and close\n"
+			"  --max-body BYTES  Stop reading a body after BYTES (default 0, no limit)\n"
+			"  --body-buffer BYTES  Buffer a body is streamed through (default 16384)\n"
+			"  --digest ALGO     Hash every body as it streams in, e.g. SHA-256, BLAKE2b(256)\n"
+			"  --threads N       Number of io_context threads (default one per core)\n"
+			"  --timeout SECONDS Per phase timeout (default 12)\n"
+			"  --coroutines      Run sessions as C++20 coroutines instead of callbacks\n"
+			"  --alloc-stats     Count heap allocations and print them per probe\n"
+			"  --tls-profile NAME  TLS policy: compatible (default), fast or strict\n"
+			"  --tls-bench N     Time N loopback handshakes per TLS profile and exit\n"
+			"  --media DIR       Take media files found in DIR over the embedded ones\n"
+			"  --max-fps N       Most frames a window draws per second (default 30, 0 no cap)\n"
+			"  --idle-sleep MS   How long an unchanged window sleeps between checks (default 20)\n"
+			"  --connect-delay MS  Delay between Happy Eyeballs connect attempts\n"
+			"                    (default 250, 0 tries addresses one after another)\n"
+			"  --session-cache N TLS sessions kept for resumption (default 10000, 0 disables)\n"
+			"  --prewarm-trust-store  Load the system trust store before any session starts\n"
+			"  --chain-cache N   Verified certificate chains kept (default 4096, 0 disables)\n"
+			"  --chain-cache-ttl SECONDS  Longest time a verified chain is trusted (default 300)\n"
+			"  --dns-ttl SECONDS Keep resolved addresses (default 60, 0 disables the cache)\n"
+			"  --dns-negative-ttl SECONDS  Keep failed lookups (default 10)\n"
+			"  --native-dns      Resolve with the built-in DNS client instead of getaddrinfo\n"
+			"  --nameserver ADDR[:PORT]  Nameserver for --native-dns, may be repeated\n"
+			"                    (default: /etc/resolv.conf)\n"
+			"  --dns-attempts N  Attempts per nameserver for --native-dns (default 2)\n"
+			"  --dns-timeout MS  Wait for an answer per attempt for --native-dns (default 1500)\n";
+	}
+};
+
+// CPU time and peak resident set size of the whole process, for the batch
+// summary.
+struct ProcessUsage {
+	std::chrono::duration<double> user{};
+	std::chrono::duration<double> system{};
+	std::size_t peakRssKiB = 0;
+	static ProcessUsage now() {
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+		auto seconds = [] (const timeval & time) {
+			return std::chrono::duration<double>{time.tv_sec + time.tv_usec / 1e6};
+		};
+		return {seconds(usage.ru_utime), seconds(usage.ru_stime), static_cast<std::size_t>(usage.ru_maxrss)};
+	}
+};
+
+std::vector<ProbeTarget> loadTargets(const CommandLine & cmd) {
+	std::vector<ProbeTarget> targets;
+	if (cmd.batchFile == "-") {
+		targets = readTargets(std::cin);
+	} else if (!cmd.batchFile.empty()) {
+		std::ifstream file{cmd.batchFile};
+		if (!file)
+			throw std::runtime_error{"Can not open target list: "s + cmd.batchFile};
+		targets = readTargets(file);
+	}
+	targets.insert(targets.end(), cmd.targets.begin(), cmd.targets.end());
+	return targets;
+}
+
+int runBatch(const CommandLine & cmd, SigMan & sigMan, IoContextPool & ioPool) {
+	const std::vector<ProbeTarget> targets = loadTargets(cmd);
+	ProbeOptions options = cmd.probeOptions;
+	options.verbose = false;
+
+	BatchProbe batch{ioPool, sigMan, targets, cmd.concurrency, std::max<std::size_t>(cmd.rounds, 1), cmd.perTargetStats, options};
+	const auto begin = std::chrono::steady_clock::now();
+	const std::uint64_t allocationsBefore = AllocationCounter::count;
+	const ProcessUsage usageBefore = ProcessUsage::now();
+	ioPool.run();
+	batch.start();
+	batch.wait();
+	ioPool.join();
+	const std::uint64_t allocations = AllocationCounter::count - allocationsBefore;
+	const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - begin;
+	const ProcessUsage usage = ProcessUsage::now();
+	const std::size_t probes = targets.size() * std::max<std::size_t>(cmd.rounds, 1);
+	std::cerr << "Probed " << targets.size() << " targets x " << cmd.rounds << " rounds, "
+		<< batch.failedCount() << " failed, "
+		<< batch.reusedCount() << " on reused connections, in "
+		<< seconds.count() << "s on " << ioPool.size() << " threads, "
+		<< (seconds.count() > 0 ? probes / seconds.count() : 0.0) << " sessions/s" << std::endl;
+	ioPool.printStats(std::cerr, seconds);
+	std::cerr << "CPU: " << (usage.user - usageBefore.user).count() << "s user, "
+		<< (usage.system - usageBefore.system).count() << "s system, "
+		<< (usage.user + usage.system - usageBefore.user - usageBefore.system).count() * 1e3 / std::max<std::size_t>(probes, 1)
+		<< "ms per probe, peak RSS " << usage.peakRssKiB / 1024.0 << " MiB" << std::endl;
+	if (AllocationCounter::enabled)
+		std::cerr << "Allocations (" << (options.coroutine ? "coroutine" : "callback") << " sessions): "
+			<< allocations << ", "
+			<< static_cast<double>(allocations) / probes
+			<< " per probe" << std::endl;
+	if (AllocationCounter::enabled)
+		std::cerr << "Handler memory: " << HandlerMemory::recycled() << " blocks recycled, "
+			<< HandlerMemory::fresh() << " taken from the heap" << std::endl;
+	std::cerr << "Session pool: " << SessionPool::created() << " sessions built, at most "
+		<< SessionPool::highWater() << " in use on one io_context" << std::endl;
+	batch.printLatency(std::cerr);
+	std::cerr << "DNS: " << ResolveCache::instance().lookups() << " lookups, "
+		<< ResolveCache::instance().cacheHits() << " cache hits, "
+		<< ResolveCache::instance().sharedHits() << " joined in flight" << std::endl;
+	if (VerifiedChainCache::enabled())
+		std::cerr << "Verified chain cache: "
+			<< VerifiedChainCache::instance().hits() << " hits, "
+			<< VerifiedChainCache::instance().misses() << " misses" << std::endl;
+	return batch.failedCount() == 0 ? 0 : 1;
+}
+
+// Runs the ProbeScheduler until Ctrl-C or --duration, then prints totals
+// like runBatch.
+int runMonitor(const CommandLine & cmd, SigMan & sigMan, IoContextPool & ioPool) {
+	const std::vector<ProbeTarget> targets = loadTargets(cmd);
+	ProbeOptions options = cmd.probeOptions;
+	options.verbose = false;
+
+	ProbeScheduler scheduler{ioPool, sigMan, targets, cmd.every, cmd.jitter, cmd.concurrency, options};
+	std::cerr << "Probing " << targets.size() << " targets every "
+		<< std::chrono::duration<double>{cmd.every}.count() << "s, Ctrl-C stops" << std::endl;
+	const auto begin = std::chrono::steady_clock::now();
+	const ProcessUsage usageBefore = ProcessUsage::now();
+	ioPool.run();
+	scheduler.start(cmd.duration);
+	scheduler.wait();
+	ioPool.join();
+	const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - begin;
+	const ProcessUsage usage = ProcessUsage::now();
+	const std::uint64_t probes = scheduler.probeCount();
+	std::cerr << "Probed " << targets.size() << " targets " << probes << " times, "
+		<< scheduler.failedCount() << " failed, "
+		<< scheduler.skippedCount() << " skipped because the previous probe had not finished, in "
+		<< seconds.count() << "s, "
+		<< (seconds.count() > 0 ? probes / seconds.count() : 0.0) << " sessions/s" << std::endl;
+	ioPool.printStats(std::cerr, seconds);
+	std::cerr << "CPU: " << (usage.user - usageBefore.user).count() << "s user, "
+		<< (usage.system - usageBefore.system).count() << "s system, "
+		<< (usage.user + usage.system - usageBefore.user - usageBefore.system).count() * 1e3 / std::max<std::uint64_t>(probes, 1)
+		<< "ms per probe, peak RSS " << usage.peakRssKiB / 1024.0 << " MiB" << std::endl;
+	scheduler.printLatency(std::cerr);
+	return scheduler.failedCount() == 0 ? 0 : 1;
+}
+
+// Prints handshakes per second and CPU time per handshake of every TLS
+// profile, so the cheapest one the probed servers accept can be picked.
+int runTlsBench(const CommandLine & cmd) {
+	HandshakeBench bench;
+	std::cerr << "Loopback TLS handshakes, " << cmd.tlsBench << " per profile:" << std::endl;
+	for (auto profile: {TlsEssentials::Profile::Compatible, TlsEssentials::Profile::Fast, TlsEssentials::Profile::Strict}) {
+		const HandshakeBench::Result result = bench.run(profile, cmd.tlsBench);
+		const double handshakes = std::max<std::size_t>(result.handshakes, 1);
+		std::cerr << "  " << std::setw(10) << std::left << TlsEssentials::profileName(profile) << std::right
+			<< std::fixed << std::setprecision(1)
+			<< " " << std::setw(8) << (result.elapsed.count() > 0 ? result.handshakes / result.elapsed.count() : 0.0) << " handshakes/s"
+			<< std::setprecision(3)
+			<< " " << std::setw(8) << result.cpu.count() * 1000 / handshakes << "ms CPU per handshake"
+			<< " " << result.failed << " failed" << std::defaultfloat << std::endl;
+	}
+	return 0;
+}
+
+int main(int argc, char * argv[]) try {
+	const CommandLine cmd{argc, argv};
+	AllocationCounter::enabled = cmd.allocStats;
+	SharedSessionCache::setCapacity(cmd.sessionCache);
+	VerifiedChainCache::configure(cmd.chainCache, cmd.chainCacheTtl);
+	ConnectionPool::configure(cmd.keepAlive, cmd.idleTimeout);
+	TlsEssentials::configure(cmd.tlsProfile);
+	for (const auto & caFile: cmd.caFiles)
+		CredentialsManager::addTrustAnchor(caFile);
+	ResolveCache::configure(cmd.dnsTtl, cmd.dnsNegativeTtl);
+	if (cmd.nativeDns)
+		DnsResolver::configure(cmd.nameservers, cmd.dnsAttempts, cmd.dnsTimeout);
+	if (cmd.prewarmTrustStore) {
+		const SharedTrustStore & trustStore = SharedTrustStore::instance();
+		std::cerr << "Trust store: " << trustStore.size() << " certificates indexed in "
+			<< std::chrono::duration<double, std::milli>{trustStore.buildTime()}.count()
+			<< "ms" << std::endl;
+	}
+	if (cmd.tlsBench > 0)
+		return runTlsBench(cmd);
 	SigMan sigMan;
+	IoContextPool ioPool{cmd.threads};
+	if ((!cmd.batchFile.empty() || !cmd.targets.empty()) && cmd.every.count() > 0)
+		return runMonitor(cmd, sigMan, ioPool);
+	if (!cmd.batchFile.empty() || !cmd.targets.empty())
+		return runBatch(cmd, sigMan, ioPool);
+	FramePacer::configure(cmd.maxFps, cmd.idleSleep);
+	AssetCache::configure(cmd.mediaDir);
 	PrintMessage printMessage{sigMan};
+	ioPool.run();
 	const irr::video::E_DRIVER_TYPE driverType = irr::video::EDT_BURNINGSVIDEO;
 	auto mainWindowThread = std::async(
 		std::launch::async,
 		startMainWindow,
 		driverType,
-		std::ref(sigMan)
+		std::ref(sigMan),
+		std::ref(ioPool),
+		std::make_shared<const ProbeOptions>(cmd.probeOptions)
 	);
+	mainWindowThread.wait();
+	ioPool.stop();
+} catch (std::exception & exc) {
+	std::cerr << exc.what() << std::endl;
+	return 2;
 } catch (...) {
 	std::cerr << "[Cpp Unknown Exception]" << std::endl;
 	return 2;
 }
-
@@ -0,0 +1,311 @@
+//
+// Copyright (c) 2022 Fas Xmut (fasxmut at protonmail dot com)
+//
+// Distributed under the Boost Software License, Version 1.0. (See accompanying
+// file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+//
+
+// A stand-in HTTPS server, so micburs can be measured without touching real
+// internet hosts. On start it makes a throw-away CA and a certificate for
+// localhost and 127.0.0.1 signed by it, and writes the CA certificate out for
+// micburs --ca-file. Every request is answered with a body of --size bytes,
+// --latency milliseconds after it was read. Connections are kept alive, so
+// micburs --keep-alive and pipelined --path targets work against it too.
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <boost/beast.hpp>
+#include <botan/asio_stream.h>
+#include <botan/auto_rng.h>
+#include <botan/ecdsa.h>
+#include <botan/x509self.h>
+#include <botan/x509_ca.h>
+#include <botan/pkcs10.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace asio = boost::asio;
+namespace beast = boost::beast;
+namespace ip = asio::ip;
+using ip::tcp;
+namespace http = beast::http;
+namespace TLS = Botan::TLS;
+using namespace std::string_literals;
+
+struct StandinOptions {
+	std::string address = "127.0.0.1";
+	unsigned short port = 8443;
+	std::size_t threads = 1;
+	std::size_t size = 1024; // Body bytes of every response
+	std::chrono::milliseconds latency{0}; // Added before every response
+	std::string caFile = "standin-ca.pem";
+
+	StandinOptions(int argc, char * argv[]) {
+		for (int i=1; i<argc; ++i) {
+			const std::string_view arg{argv[i]};
+			auto value = [&] () -> std::string {
+				if (i+1 >= argc)
+					throw std::runtime_error{"Missing value for "s + argv[i]};
+				return argv[++i];
+			};
+			if (arg == "--address")
+				address = value();
+			else if (arg == "--port")
+				port = static_cast<unsigned short>(std::stoul(value()));
+			else if (arg == "--threads")
+				threads = std::max<std::size_t>(std::stoul(value()), 1);
+			else if (arg == "--size")
+				size = std::stoul(value());
+			else if (arg == "--latency")
+				latency = std::chrono::milliseconds{std::stol(value())};
+			else if (arg == "--ca-out")
+				caFile = value();
+			else if (arg == "--help" || arg == "-h")
+				throw std::runtime_error{usage()};
+			else
+				throw std::runtime_error{"Unknown option: "s + argv[i] + "\n" + usage()};
+		}
+	}
+	static std::string usage() {
+		return
+			"Usage: standin [options]\n"
+			"  --address ADDR    Address to listen on (default 127.0.0.1)\n"
+			"  --port PORT       Port to listen on (default 8443)\n"
+			"  --threads N       Number of io_context threads (default 1)\n"
+			"  --size BYTES      Body size of every response (default 1024)\n"
+			"  --latency MS      Delay before every response (default 0)\n"
+			"  --ca-out FILE     Where the CA certificate is written (default standin-ca.pem)\n";
+	}
+};
+
+// The CA and the server certificate it signs, both on ECDSA P-256 keys and
+// made anew on every start. System_RNG can be shared by all threads.
+class StandinCredentials: public Botan::Credentials_Manager {
+private:
+	Botan::ECDSA_PrivateKey caKey;
+	Botan::X509_Certificate caCertificate;
+	Botan::ECDSA_PrivateKey serverKey;
+	Botan::X509_Certificate serverCertificate;
+public:
+	explicit StandinCredentials(Botan::RandomNumberGenerator & rng)
+	:
+		caKey{rng, Botan::EC_Group{"secp256r1"}},
+		caCertificate{makeCa(caKey, rng)},
+		serverKey{rng, Botan::EC_Group{"secp256r1"}},
+		serverCertificate{makeServer(caCertificate, caKey, serverKey, rng)}
+	{
+	}
+	const Botan::X509_Certificate & ca() const {
+		return caCertificate;
+	}
+	std::vector<Botan::X509_Certificate> cert_chain(
+		const std::vector<std::string> & keyTypes,
+		const std::string & type,
+		const std::string &
+	) override {
+		if (type != "tls-server" || std::find(keyTypes.begin(), keyTypes.end(), "ECDSA") == keyTypes.end())
+			return {};
+		return {serverCertificate, caCertificate};
+	}
+	Botan::Private_Key * private_key_for(
+		const Botan::X509_Certificate &,
+		const std::string &,
+		const std::string &
+	) override {
+		return &serverKey;
+	}
+private:
+	static Botan::X509_Certificate makeCa(const Botan::Private_Key & key, Botan::RandomNumberGenerator & rng) {
+		Botan::X509_Cert_Options options{"micburs standin CA"};
+		options.CA_key();
+		return Botan::X509::create_self_signed_cert(options, key, "SHA-256", rng);
+	}
+	static Botan::X509_Certificate makeServer(
+		const Botan::X509_Certificate & caCertificate,
+		const Botan::Private_Key & caKey,
+		const Botan::Private_Key & key,
+		Botan::RandomNumberGenerator & rng
+	) {
+		Botan::X509_Cert_Options options{"localhost"};
+		options.dns = "localhost";
+		options.ip = "127.0.0.1";
+		const Botan::X509_CA ca{caCertificate, caKey, "SHA-256", rng};
+		const auto now = std::chrono::system_clock::now();
+		return ca.sign_request(
+			Botan::X509::create_cert_req(options, key, "SHA-256", rng),
+			rng,
+			Botan::X509_Time{now - std::chrono::hours{1}},
+			Botan::X509_Time{now + std::chrono::hours{24 * 30}}
+		);
+	}
+};
+
+// One client connection on its own strand: handshake, then read a request,
+// wait out the latency, answer, for as long as the client keeps it alive.
+class StandinSession: public std::enable_shared_from_this<StandinSession> {
+private:
+	TLS::Stream<beast::tcp_stream> stream;
+	beast::flat_buffer buffer;
+	http::request<http::empty_body> req;
+	http::response<http::span_body<const char>> res;
+	asio::steady_timer delay;
+	const std::string & body;
+	const std::chrono::milliseconds latency;
+public:
+	StandinSession(
+		TLS::Context & context,
+		tcp::socket && socket,
+		const std::string & _body_,
+		std::chrono::milliseconds _latency_
+	)
+	:
+		stream{context, std::move(socket)},
+		delay{stream.get_executor()},
+		body{_body_},
+		latency{_latency_}
+	{
+	}
+	void start() {
+		stream.next_layer().expires_after(std::chrono::seconds{30});
+		stream.async_handshake(
+			TLS::Connection_Side::SERVER,
+			[self=this->shared_from_this()] (
+				beast::error_code ec
+			) {
+				if (ec)
+					return;
+				self->read();
+			}
+		);
+	}
+private:
+	void read() {
+		req = {};
+		stream.next_layer().expires_after(std::chrono::seconds{30});
+		http::async_read(
+			stream,
+			buffer,
+			req,
+			[self=this->shared_from_this()] (
+				beast::error_code ec,
+				std::size_t
+			) {
+				if (ec)
+					return;
+				if (self->latency.count() == 0)
+					return self->write();
+				self->delay.expires_after(self->latency);
+				self->delay.async_wait(
+					[self=self] (
+						beast::error_code ec
+					) {
+						if (ec)
+							return;
+						self->write();
+					}
+				);
+			}
+		);
+	}
+	void write() {
+		res = {};
+		res.result(http::status::ok);
+		res.version(req.version());
+		res.set(http::field::server, "micburs-standin");
+		res.set(http::field::content_type, "application/octet-stream");
+		res.keep_alive(req.keep_alive());
+		if (req.method() == http::verb::head) {
+			res.content_length(body.size());
+		} else {
+			res.body() = {body.data(), body.size()};
+			res.prepare_payload();
+		}
+		http::async_write(
+			stream,
+			res,
+			[self=this->shared_from_this()] (
+				beast::error_code ec,
+				std::size_t
+			) {
+				if (ec)
+					return;
+				if (!self->res.keep_alive())
+					return self->stream.async_shutdown([self=self] (beast::error_code) {});
+				self->read();
+			}
+		);
+	}
+};
+
+class StandinServer {
+private:
+	asio::io_context ioContext;
+	tcp::acceptor acceptor;
+	Botan::System_RNG rng;
+	StandinCredentials credentials{rng};
+	TLS::Session_Manager_In_Memory sessionMan{rng};
+	TLS::Policy policy;
+	TLS::Context context{credentials, rng, sessionMan, policy};
+	const std::string body;
+	const std::chrono::milliseconds latency;
+public:
+	explicit StandinServer(const StandinOptions & options)
+	:
+		ioContext{static_cast<int>(options.threads)},
+		acceptor{ioContext, tcp::endpoint{ip::make_address(options.address), options.port}},
+		body(options.size, 'x'),
+		latency{options.latency}
+	{
+	}
+	const Botan::X509_Certificate & ca() const {
+		return credentials.ca();
+	}
+	tcp::endpoint endpoint() const {
+		return acceptor.local_endpoint();
+	}
+	void run(std::size_t threads) {
+		this->accept();
+		std::vector<std::thread> workers;
+		for (std::size_t i=1; i<threads; ++i)
+			workers.emplace_back([this] { ioContext.run(); });
+		ioContext.run();
+		for (auto & worker: workers)
+			worker.join();
+	}
+private:
+	void accept() {
+		acceptor.async_accept(
+			asio::make_strand(ioContext),
+			[this] (
+				beast::error_code ec,
+				tcp::socket socket
+			) {
+				if (!ec) {
+					socket.set_option(tcp::no_delay{true});
+					std::make_shared<StandinSession>(context, std::move(socket), body, latency)->start();
+				}
+				this->accept();
+			}
+		);
+	}
+};
+
+int main(int argc, char * argv[]) try {
+	const StandinOptions options{argc, argv};
+	StandinServer server{options};
+	std::ofstream{options.caFile} << server.ca().PEM_encode();
+	std::cerr << "standin listening on " << server.endpoint()
+		<< ", " << options.size << " byte bodies, " << options.latency.count() << "ms latency, "
+		<< options.threads << " threads, CA written to " << options.caFile << std::endl;
+	server.run(options.threads);
+} catch (std::exception & exc) {
+	std::cerr << exc.what() << std::endl;
+	return 2;
+}